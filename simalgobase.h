@@ -2,6 +2,7 @@
 #define _ALGOBASE_H_
 
 #include "simiterator_base.h"
+#include <utility> //for std::move
 
 namespace SimSTL {
 
@@ -12,6 +13,15 @@ max(const T& a, const T& b)
         return a < b ? b : a;
 }
 
+template <typename T>
+inline void
+swap(T& a, T& b)
+{
+        T tmp = std::move(a);
+        a = std::move(b);
+        b = std::move(tmp);
+}
+
 template <typename ForwardIterator, typename T>
 void
 fill(ForwardIterator first, ForwardIterator last, const T& value)
@@ -111,6 +121,26 @@ copy_backward(BidirectionalIterator1 first, BidirectionalIterator1 last,
                                iterator_category(first), distance_type(first));
 }
 
+//move与move_backward：同copy与copy_backward，但移动赋值，源区间的元素处于被移动后的状态
+template <typename InputIterator, typename OutputIterator>
+OutputIterator
+move(InputIterator first, InputIterator last, OutputIterator result)
+{
+        for (; first != last; ++first, ++result)
+                *result = std::move(*first);
+        return result;
+}
+
+template <typename BidirectionalIterator1, typename BidirectionalIterator2>
+BidirectionalIterator2
+move_backward(BidirectionalIterator1 first, BidirectionalIterator1 last,
+              BidirectionalIterator2 result)
+{
+        while (first != last)
+                *--result = std::move(*--last);
+        return result;
+}
+
 
 
 
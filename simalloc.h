@@ -6,11 +6,132 @@
 #       define __THROW_BAD_ALLOC throw bad_alloc
 #elif   !defined(__THROW_BAD_ALLOC)
 #       include <iostream>
-#       define __THROW_BAD_ALLOC std::cerr << "out of memory" << std::endl; exit(1)
+#       define __THROW_BAD_ALLOC do { std::cerr << "out of memory" << std::endl; exit(1); } while (0)
 #endif
 
-namespace SimiSTL {
+//定义__SIMSTL_ALLOC_STATS时统计配置器的运行情况，否则统计代码不参与编译
+#ifdef __SIMSTL_ALLOC_STATS
+#       define __ALLOC_STAT(stmt) stmt
+#else
+#       define __ALLOC_STAT(stmt)
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include "simtype_traits.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#       include <sys/mman.h>
+#endif
+
+namespace SimSTL {
+
+
+//区块链：allocate_chain/deallocate_chain用每个区块起始处的指针串起多个区块
+inline void *__chain_next(void *p) { return *(void **)p; }
+inline void __chain_link(void *p, void *next) { *(void **)p = next; }
+
+//内存压力回调：内存不足时，在调用oom处理函数之前依次调用已登记的回调，
+//让容器、缓存以及第二级配置器交出缓存的内存。回调返回释放的字节数。
+//回调中可以释放内存，但不应再申请内存。
+template <int inst>
+class __memory_pressure
+{
+public:
+        typedef size_t (*handler_type)(size_t bytes_needed, void *context);
+
+        //登记回调，已满时返回false
+        static bool add_handler(handler_type f, void *context)
+        {
+                std::lock_guard<std::mutex> guard(registry_mutex());
+                for (int i = 0; i < __MAX_HANDLERS; i++)
+                {
+                        if (handlers[i].f == NULL)
+                        {
+                                handlers[i].f = f;
+                                handlers[i].context = context;
+                                return true;
+                        }
+                }
+                return false;
+        }
+
+        static void remove_handler(handler_type f, void *context)
+        {
+                std::lock_guard<std::mutex> guard(registry_mutex());
+                for (int i = 0; i < __MAX_HANDLERS; i++)
+                {
+                        if (handlers[i].f == f && handlers[i].context == context)
+                                handlers[i].f = NULL;
+                }
+        }
+
+        //按登记顺序调用回调，释放的字节数达到bytes_needed即停止，返回释放的总字节数
+        static size_t relieve(size_t bytes_needed)
+        {
+                entry snapshot[__MAX_HANDLERS];
+                {
+                        //复制一份后再调用，回调中可以登记或注销回调
+                        std::lock_guard<std::mutex> guard(registry_mutex());
+                        for (int i = 0; i < __MAX_HANDLERS; i++)
+                                snapshot[i] = handlers[i];
+                }
+
+                size_t released = 0;
+                for (int i = 0; i < __MAX_HANDLERS && released < bytes_needed; i++)
+                {
+                        if (snapshot[i].f != NULL)
+                                released += (*snapshot[i].f)(bytes_needed - released, snapshot[i].context);
+                }
+                return released;
+        }
+
+        //在作用域内登记回调
+        class registration
+        {
+        public:
+                registration(handler_type f, void *context) : f(f), context(context)
+                {
+                        add_handler(f, context);
+                }
+
+                ~registration() { remove_handler(f, context); }
+
+        private:
+                registration(const registration&);
+                registration& operator=(const registration&);
+
+        private:
+                handler_type f;
+                void *context;
+        };
+
+private:
+        enum {__MAX_HANDLERS = 32};
+
+        struct entry
+        {
+                handler_type f;
+                void *context;
+        };
 
+        static entry handlers[__MAX_HANDLERS];
+
+        static std::mutex& registry_mutex()
+        {
+                static std::mutex m;
+                return m;
+        }
+};
+
+template <int inst>
+typename __memory_pressure<inst>::entry __memory_pressure<inst>::handlers[__MAX_HANDLERS];
+
+typedef __memory_pressure<0> memory_pressure;
 
 //第一级配置器
 template <int inst>
@@ -19,8 +140,26 @@ class __malloc_alloc
 private:
         static void *oom_malloc(size_t);
         static void *oom_realloc(void *, size_t);
+        static void *oom_aligned(size_t, size_t);
         static void (*malloc_alloc_oom_handler)();
 
+        static void *try_aligned(size_t n, size_t align)
+        {
+#if defined(__unix__) || defined(__APPLE__)
+                void *result;
+                return posix_memalign(&result, align, n) == 0 ? result : NULL;
+#else
+                //原始指针保存在对齐地址之前
+                char *raw = (char *)malloc(n + align);
+                if (raw == NULL)
+                        return NULL;
+                char *result = (char *)(((size_t)raw + sizeof(void *) + align - 1)
+                                        & ~(size_t)(align - 1));
+                ((void **)result)[-1] = raw;
+                return result;
+#endif
+        }
+
 public:
         static void *allocate(size_t n)
         {
@@ -32,6 +171,26 @@ public:
 
         static void deallocate(void *p, size_t) { free(p); }
 
+        //align为2的幂
+        static void *allocate_aligned(size_t n, size_t align)
+        {
+                if (align < sizeof(void *))
+                        align = sizeof(void *);
+                void *result = try_aligned(n, align);
+                if (NULL == result)
+                        result = oom_aligned(n, align);
+                return result;
+        }
+
+        static void deallocate_aligned(void *p, size_t, size_t)
+        {
+#if defined(__unix__) || defined(__APPLE__)
+                free(p);
+#else
+                free(((void **)p)[-1]);
+#endif
+        }
+
         static void *reallocate(void *p, size_t, size_t new_size)
         {
                 void *result = realloc(p, new_size);
@@ -40,13 +199,48 @@ public:
                 return result;
         }
 
+        //n字节的请求实际可用的字节数
+        static size_t good_size(size_t n) { return n; }
+
+        static void *allocate_chain(size_t n, size_t count)
+        {
+                void *head = NULL;
+                while (count-- > 0)
+                {
+                        void *p = allocate(n);
+                        __chain_link(p, head);
+                        head = p;
+                }
+                return head;
+        }
+
+        static void deallocate_chain(void *first, void *, size_t n, size_t count)
+        {
+                while (count-- > 0)
+                {
+                        void *next = __chain_next(first);
+                        deallocate(first, n);
+                        first = next;
+                }
+        }
+
         static void (*set_malloc_handler(void (*f)()))()
         {
+                void (*old)() = malloc_alloc_oom_handler;
                 malloc_alloc_oom_handler = f;
+                return old;
         }
 
+        //oom处理函数被调用的次数
+        static size_t oom_calls() { return oom_counter.load(std::memory_order_relaxed); }
+
+private:
+        static std::atomic<size_t> oom_counter;
 };
 
+template <int inst>
+std::atomic<size_t> __malloc_alloc<inst>::oom_counter(0);
+
 template <int inst>
 void (* __malloc_alloc<inst>::malloc_alloc_oom_handler)() = NULL;
 
@@ -56,11 +250,20 @@ void* __malloc_alloc<inst>::oom_malloc(size_t n)
         void (*my_malloc_handler)();
         void *result;
 
+        //先让已登记的回调交出缓存的内存
+        if (memory_pressure::relieve(n) != 0)
+        {
+                result = malloc(n);
+                if (result)
+                        return result;
+        }
+
         for (;;)
         {
                 my_malloc_handler = malloc_alloc_oom_handler;
                 if (NULL == my_malloc_handler)
                         __THROW_BAD_ALLOC;
+                __ALLOC_STAT(oom_counter.fetch_add(1, std::memory_order_relaxed));
                 (*my_malloc_handler)();
                 result = malloc(n);
                 if (result)
@@ -74,11 +277,20 @@ void* __malloc_alloc<inst>::oom_realloc(void *p, size_t n)
         void (*my_malloc_handler)();
         void *result;
 
+        //先让已登记的回调交出缓存的内存
+        if (memory_pressure::relieve(n) != 0)
+        {
+                result = realloc(p, n);
+                if (result)
+                        return result;
+        }
+
         for (;;)
         {
                 my_malloc_handler = malloc_alloc_oom_handler;
                 if (NULL == my_malloc_handler)
                         __THROW_BAD_ALLOC;
+                __ALLOC_STAT(oom_counter.fetch_add(1, std::memory_order_relaxed));
                 (*my_malloc_handler)();
                 result = realloc(p, n);
                 if (result)
@@ -87,11 +299,133 @@ void* __malloc_alloc<inst>::oom_realloc(void *p, size_t n)
 
 }
 
+template <int inst>
+void* __malloc_alloc<inst>::oom_aligned(size_t n, size_t align)
+{
+        void (*my_malloc_handler)();
+        void *result;
+
+        //先让已登记的回调交出缓存的内存
+        if (memory_pressure::relieve(n) != 0)
+        {
+                result = try_aligned(n, align);
+                if (result)
+                        return result;
+        }
+
+        for (;;)
+        {
+                my_malloc_handler = malloc_alloc_oom_handler;
+                if (NULL == my_malloc_handler)
+                        __THROW_BAD_ALLOC;
+                __ALLOC_STAT(oom_counter.fetch_add(1, std::memory_order_relaxed));
+                (*my_malloc_handler)();
+                result = try_aligned(n, align);
+                if (result)
+                        return result;
+        }
+}
+
 typedef __malloc_alloc<0> malloc_alloc;
 
 
+//统计计数器：同一时刻只有一个线程写入（线程缓存的所有者，或持有中心池锁
+//的线程），因此用relaxed的读写代替原子加法，其他线程可以随时读取
+class __alloc_counter
+{
+public:
+        size_t get() const { return value.load(std::memory_order_relaxed); }
+        void set(size_t n) { value.store(n, std::memory_order_relaxed); }
+        void add(size_t n) { set(get() + n); }
+        void sub(size_t n) { set(get() - n); }
+        __alloc_counter& operator++() { add(1); return *this; }
+        __alloc_counter& operator--() { sub(1); return *this; }
+
+private:
+        std::atomic<size_t> value;
+};
+
+//第二级配置器某一分级的统计
+struct alloc_class_stats
+{
+        size_t block_size;
+        size_t hits;            //自由链表（线程缓存）直接命中
+        size_t misses;          //自由链表为空
+        size_t refills;         //重新填充自由链表的次数
+        size_t free_blocks;     //自由链表与线程缓存中的块数
+        size_t free_bytes;
+};
+
+//第二级配置器的统计快照，未定义__SIMSTL_ALLOC_STATS时计数恒为0
+struct alloc_stats
+{
+        enum {NCLASSES = 48};
+
+        alloc_class_stats classes[NCLASSES];
+        size_t heap_size;       //从系统获取的字节数
+        size_t chunk_count;     //大块个数
+        size_t chunk_allocs;    //向内存池申请区块的次数
+        size_t slab_fills;      //新建slab的次数
+        size_t fragments;       //chunk_alloc放回自由链表的残余块数
+        size_t fragment_bytes;
+        size_t oom_calls;       //第一级配置器调用oom处理函数的次数
+};
+
+//内存池的大块内存来源，allocate可把bytes上调为实际得到的字节数
+class malloc_chunk_source
+{
+public:
+        static void *allocate(size_t& bytes) { return malloc(bytes); }
+        static void deallocate(void *p, size_t) { free(p); }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+//匿名mmap映射的大块，按2MB大页对齐并建议内核使用透明大页，
+//以减少大量小节点分散在malloc区域时的TLB缺失
+class mmap_chunk_source
+{
+public:
+        enum {HUGE_PAGE_SIZE = 2 * 1024 * 1024};
+
+        static void *allocate(size_t& bytes)
+        {
+                bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+
+                //多映射一个大页，再裁掉首尾未对齐的部分
+                size_t len = bytes + HUGE_PAGE_SIZE;
+                void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED)
+                        return NULL;
+
+                char *start = (char *)p;
+                char *aligned = (char *)(((size_t)start + HUGE_PAGE_SIZE - 1)
+                                         & ~(size_t)(HUGE_PAGE_SIZE - 1));
+                if (aligned != start)
+                        munmap(start, aligned - start);
+                if (start + len != aligned + bytes)
+                        munmap(aligned + bytes, start + len - (aligned + bytes));
+#ifdef MADV_HUGEPAGE
+                madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+                return aligned;
+        }
+
+        static void deallocate(void *p, size_t bytes) { munmap(p, bytes); }
+};
+#endif
+
 //第二级配置器
-template <bool threads>
+//threads为true时，每个线程拥有私有的自由链表（线程缓存），分配与回收都在
+//线程缓存中完成，不需要加锁；线程缓存为空时从中心内存池批量取__NOBJS块，
+//线程缓存过长时批量归还中心内存池。只有批量操作需要持有中心池的锁。
+//某线程分配的区块可以在任何线程释放，释放的区块进入释放线程的缓存。
+//
+//不超过__MAX_BYTES的区块按8字节分级，由内存池切分；__MAX_BYTES到
+//__MAX_SLAB_BYTES之间的区块按几何级数分级（每个2的幂区间分4级），每级
+//从独立的页面级slab切分；更大的区块交给第一级配置器。
+//内存池与slab的大块内存由ChunkSource提供。
+template <bool threads, typename ChunkSource = malloc_chunk_source>
 class __default_alloc
 {
 public:
@@ -99,6 +433,38 @@ public:
         static void deallocate(void *p, size_t n);
         static void *reallocate(void *p, size_t old_size, size_t new_size);
 
+        //n字节的请求实际占用的字节数，即所在分级的区块大小，
+        //容器按它确定容量可以用满区块而不浪费
+        static size_t good_size(size_t n)
+        {
+                if (n == 0 || n > (size_t)__MAX_SLAB_BYTES)
+                        return n;
+                return CLASS_SIZE(CLASS_INDEX(n));
+        }
+
+        //按align（2的幂）对齐分配。align不超过__ALIGN时与allocate相同；
+        //否则多取align字节，对齐后的地址之前保存原始区块的指针
+        static void *allocate_aligned(size_t n, size_t align);
+        static void deallocate_aligned(void *p, size_t n, size_t align);
+
+        //一次取count个大小为n的区块，用区块起始处的指针串成链表返回，
+        //每个分级只需摘取或拼接一次自由链表
+        static void *allocate_chain(size_t n, size_t count);
+
+        //归还以first开头、last结尾、共count块的区块链，整条拼接到自由链表
+        static void deallocate_chain(void *first, void *last, size_t n, size_t count);
+
+        //将当前线程缓存的区块全部归还中心内存池
+        static void flush_thread_cache();
+
+        //将完全空闲的大块内存归还系统，返回释放的字节数
+        //threads为true时，其他线程缓存中的区块会使所在大块无法释放
+        static size_t trim();
+
+        //统计快照与输出，供监控使用
+        static void get_stats(alloc_stats& stats);
+        static void dump_stats(std::ostream& os);
+
 private:
         //返回一个大小为n的块,重新填充链表
         static void *refill(size_t n);
@@ -119,6 +485,24 @@ private:
         //填充链表时的块数
         enum {__NOBJS = 20};
 
+        //线程缓存每条链表最多保留的块数，超过则归还__NOBJS块给中心池
+        enum {__MAX_CACHED = 2 * __NOBJS};
+
+        //slab分级的区块上限
+        enum {__MAX_SLAB_BYTES = 32768};
+
+        //slab分级个数：(128, 32768]共8个2的幂区间，每个区间4级
+        enum {__NSLABCLASSES = 32};
+
+        //全部分级个数，前__NFREELISTS级为8字节分级
+        enum {__NCLASSES = __NFREELISTS + __NSLABCLASSES};
+
+        //slab按页面大小向上取整，至少容纳__SLAB_MIN_OBJS个区块
+        enum {__SLAB_PAGE = 4096};
+        enum {__SLAB_MIN_OBJS = 8};
+
+        static_assert((int)__NCLASSES == (int)alloc_stats::NCLASSES, "alloc_stats size mismatch");
+
 private:
         //自由链表
         union obj
@@ -127,8 +511,8 @@ private:
                 char data[1];
         };
 
-        //自由链表数组
-        static obj *volatile free_list[__NFREELISTS];
+        //自由链表数组，下标为分级号
+        static obj *volatile free_list[__NCLASSES];
 
         //字节上调为8的倍数
         static size_t ROUND_UP(size_t bytes)
@@ -142,95 +526,570 @@ private:
                 return (bytes + __ALIGN - 1) / __ALIGN - 1;
         }
 
+        //向下取整的log2
+        static size_t LOG2(size_t x)
+        {
+#if defined(__GNUC__)
+                return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x);
+#else
+                size_t r = 0;
+                while (x >>= 1)
+                        ++r;
+                return r;
+#endif
+        }
+
+        //选择分级，小区块仍走FREELIST_INDEX
+        static size_t CLASS_INDEX(size_t bytes)
+        {
+                if (bytes <= (size_t)__MAX_BYTES)
+                        return FREELIST_INDEX(bytes);
+                size_t m = bytes - 1;
+                size_t lg = LOG2(m);  //lg >= 7
+                return __NFREELISTS + (lg - 7) * 4 + (m >> (lg - 2)) - 4;
+        }
+
+        //分级对应的区块大小
+        static size_t CLASS_SIZE(size_t index)
+        {
+                if (index < (size_t)__NFREELISTS)
+                        return (index + 1) * __ALIGN;
+                index -= __NFREELISTS;
+                return (index % 4 + 5) << (index / 4 + 5);
+        }
+
+        //线程缓存与中心池之间一批搬运的块数
+        static int BATCH_OBJS(size_t n)
+        {
+                if (n <= (size_t)__MAX_BYTES)
+                        return __NOBJS;
+                int nobjs = (int)(4 * __SLAB_PAGE / n);
+                return nobjs < 2 ? 2 : (nobjs > __NOBJS ? __NOBJS : nobjs);
+        }
+
 private:
         static char *start_free;
         static char *end_free;
         static size_t heap_size;
+
+private:
+        //内存池向系统申请的大块内存，头部记录链接和可用字节数
+        //按16字节对齐，保持slab中区块原有的对齐
+        struct alignas(16) chunk_header
+        {
+                chunk_header *next;
+                size_t size;            //已切分或可切分的字节数
+                size_t total;           //向ChunkSource申请的字节数（含头部）
+                size_t free_bytes;      //trim时统计的空闲字节数
+                bool from_malloc_alloc; //由第一级配置器分配
+        };
+
+        static chunk_header *chunk_list;
+        static size_t chunk_count;
+
+        //向ChunkSource申请一个可用字节数至少为bytes的大块并登记，bytes返回实际可用字节数
+        //use_malloc_alloc为true时改由第一级配置器分配，以便调用oom处理函数
+        static char *chunk_get(size_t& bytes, bool use_malloc_alloc);
+
+        //将大块归还其来源
+        static void chunk_put(chunk_header *h);
+
+        //为大小为n的slab分级申请一个slab，切分后全部放入中心自由链表
+        static bool slab_fill(size_t n);
+
+        //trim的实现，调用者须持有中心池的锁
+        static size_t trim_locked();
+
+        static int chunk_compare(const void *a, const void *b);
+
+        //查找p所属的大块：chunks为按地址排序的大块数组时二分查找，
+        //为NULL时（内存不足，无法分配数组）顺序查找chunk_list
+        static chunk_header *chunk_find(chunk_header **chunks, size_t n, const char *p);
+
+        //内存压力回调：归还线程缓存并释放完全空闲的大块
+        static size_t pressure_handler(size_t bytes_needed, void *context);
+
+private:
+        //中心内存池的锁，threads为false时不加锁。
+        //内存不足时内存压力回调可能在持有锁的线程中再次进入内存池，因此用递归锁
+        static std::recursive_mutex& pool_mutex()
+        {
+                static std::recursive_mutex m;
+                return m;
+        }
+
+        class lock
+        {
+        public:
+                lock() { if (threads) pool_mutex().lock(); }
+                ~lock() { if (threads) pool_mutex().unlock(); }
+
+        private:
+                lock(const lock&);
+                lock& operator=(const lock&);
+        };
+
+        //线程缓存，无需构造
+        struct thread_cache
+        {
+                obj *free_list[__NCLASSES];
+                __alloc_counter length[__NCLASSES];
+                bool registered;  //已登记线程退出时的回收
+                bool exited;      //线程正在退出，缓存已归还
+#ifdef __SIMSTL_ALLOC_STATS
+                __alloc_counter hits[__NCLASSES];
+                __alloc_counter misses[__NCLASSES];
+                thread_cache *prev_cache;  //已登记的线程缓存链表
+                thread_cache *next_cache;
+#endif
+        };
+
+        //线程退出时将线程缓存归还中心内存池
+        struct thread_cache_reaper
+        {
+                ~thread_cache_reaper()
+                {
+                        flush_thread_cache();
+                        tls_cache.exited = true;
+                        __ALLOC_STAT(unregister_cache(tls_cache));
+                }
+        };
+
+        static thread_local thread_cache tls_cache;
+
+        //首次使用线程缓存时登记线程退出时的回收
+        static void register_thread_cache(thread_cache& tc);
+
+        static void *thread_allocate(size_t n);
+        static void thread_deallocate(void *p, size_t n);
+
+        //从中心内存池取至多nobjs个大小为n的块，以链表形式返回，nobjs返回实际块数
+        static obj *central_fetch(size_t n, int& nobjs);
+
+        //将链表[first, last]归还中心内存池
+        static void central_release(obj *first, obj *last, size_t n);
+
+private:
+#ifdef __SIMSTL_ALLOC_STATS
+        static __alloc_counter stat_hits[__NCLASSES];
+        static __alloc_counter stat_misses[__NCLASSES];
+        static __alloc_counter stat_refills[__NCLASSES];
+        static __alloc_counter stat_chunk_allocs;
+        static __alloc_counter stat_slab_fills;
+        static __alloc_counter stat_fragments;
+        static __alloc_counter stat_fragment_bytes;
+        static thread_cache *cache_list;
+
+        static void register_cache(thread_cache& tc);
+        static void unregister_cache(thread_cache& tc);
+#endif
 };
 
 //内存池起始位置
-template <bool threads>
-char *__default_alloc<threads>::start_free = NULL;
+template <bool threads, typename ChunkSource>
+char *__default_alloc<threads, ChunkSource>::start_free = NULL;
 
 //内存池结束位置
-template <bool threads>
-char *__default_alloc<threads>::end_free = NULL;
+template <bool threads, typename ChunkSource>
+char *__default_alloc<threads, ChunkSource>::end_free = NULL;
 
-template <bool threads>
-size_t __default_alloc<threads>::heap_size = 0;
+template <bool threads, typename ChunkSource>
+size_t __default_alloc<threads, ChunkSource>::heap_size = 0;
 
-template <bool threads>
-typename __default_alloc<threads>::obj *volatile
-__default_alloc<threads>::free_list[__NFREELISTS] =
-        {
-                0, 0, 0, 0,
-                0, 0, 0, 0,
-                0, 0, 0, 0,
-                0, 0, 0, 0,
-        };
+template <bool threads, typename ChunkSource>
+typename __default_alloc<threads, ChunkSource>::chunk_header *
+__default_alloc<threads, ChunkSource>::chunk_list = NULL;
 
-template <bool threads>
-void *__default_alloc<threads>::allocate(size_t n)
+template <bool threads, typename ChunkSource>
+size_t __default_alloc<threads, ChunkSource>::chunk_count = 0;
+
+template <bool threads, typename ChunkSource>
+typename __default_alloc<threads, ChunkSource>::obj *volatile
+__default_alloc<threads, ChunkSource>::free_list[__NCLASSES] = { 0 };
+
+template <bool threads, typename ChunkSource>
+thread_local typename __default_alloc<threads, ChunkSource>::thread_cache
+__default_alloc<threads, ChunkSource>::tls_cache;
+
+#ifdef __SIMSTL_ALLOC_STATS
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_hits[__NCLASSES];
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_misses[__NCLASSES];
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_refills[__NCLASSES];
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_chunk_allocs;
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_slab_fills;
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_fragments;
+
+template <bool threads, typename ChunkSource>
+__alloc_counter __default_alloc<threads, ChunkSource>::stat_fragment_bytes;
+
+template <bool threads, typename ChunkSource>
+typename __default_alloc<threads, ChunkSource>::thread_cache *
+__default_alloc<threads, ChunkSource>::cache_list = NULL;
+#endif
+
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::allocate(size_t n)
 {
         obj *volatile *my_free_list;
         obj *result;
-        if (n > (size_t)__MAX_BYTES) //调用第一级配置器
+        if (n > (size_t)__MAX_SLAB_BYTES) //调用第一级配置器
                 return malloc_alloc::allocate(n);
 
-        my_free_list = free_list + FREELIST_INDEX(n);
+        if (threads)
+                return thread_allocate(n);
+
+        size_t index = CLASS_INDEX(n);
+        my_free_list = free_list + index;
         result = *my_free_list;
         if (result == NULL)
         {
                 //第n号链表无内存块，则准备重新填充该链表
-                void *r = refill(ROUND_UP(n));
+                __ALLOC_STAT(++stat_misses[index]);
+                void *r = refill(CLASS_SIZE(index));
                 return r;
         }
+        __ALLOC_STAT(++stat_hits[index]);
         *my_free_list = result->free_list_link;
         return result;
 }
 
-template <bool threads>
-void __default_alloc<threads>::deallocate(void *p, size_t n)
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::deallocate(void *p, size_t n)
 {
-        //大于__MAX_BYTES，则释放该内存
-        if (n > (size_t)__MAX_BYTES)
+        //大于__MAX_SLAB_BYTES，则释放该内存
+        if (n > (size_t)__MAX_SLAB_BYTES)
+        {
                 malloc_alloc::deallocate(p, n);
+                return ;
+        }
+
+        if (threads)
+        {
+                thread_deallocate(p, n);
+                return ;
+        }
 
         obj *q = (obj *)p;
         obj *volatile *my_free_list;
 
-        my_free_list = free_list + FREELIST_INDEX(n);
-        //小于__MAX_BYTES，则回收区块,并未释放
+        my_free_list = free_list + CLASS_INDEX(n);
+        //不大于__MAX_SLAB_BYTES，则回收区块,并未释放
         q->free_list_link = *my_free_list;
         *my_free_list = q;
 }
 
-template <bool threads>
-void *__default_alloc<threads>::reallocate
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::reallocate
     (void *p, size_t old_size, size_t new_size)
 {
-        obj *volatile *my_free_list;
-        obj *result;
-        if (new_size > (size_t)__MAX_BYTES) //调用第一级配置器
+        //新旧大小都由第一级配置器负责，交给realloc，大块由系统搬移页面而不是复制
+        if (old_size > (size_t)__MAX_SLAB_BYTES && new_size > (size_t)__MAX_SLAB_BYTES)
                 return malloc_alloc::reallocate(p, old_size, new_size);
 
-        my_free_list = free_list + FREELIST_INDEX(new_size);
-        result = *my_free_list;
+        //属于同一分级，区块本身就足够大
+        if (old_size <= (size_t)__MAX_SLAB_BYTES && new_size <= (size_t)__MAX_SLAB_BYTES
+            && CLASS_INDEX(old_size) == CLASS_INDEX(new_size))
+                return p;
+
+        void *result = allocate(new_size);
+        memcpy(result, p, old_size < new_size ? old_size : new_size);
+        deallocate(p, old_size);
+        return result;
+}
+
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::allocate_aligned(size_t n, size_t align)
+{
+        if (align <= (size_t)__ALIGN)
+                return allocate(n);
+
+        size_t total = n + align;
+        if (total > (size_t)__MAX_SLAB_BYTES)
+                return malloc_alloc::allocate_aligned(n, align);
+
+        char *raw = (char *)allocate(total);
+        char *result = (char *)(((size_t)raw + sizeof(void *) + align - 1) & ~(size_t)(align - 1));
+        ((void **)result)[-1] = raw;
+        return result;
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::deallocate_aligned(void *p, size_t n, size_t align)
+{
+        if (align <= (size_t)__ALIGN)
+        {
+                deallocate(p, n);
+                return ;
+        }
+
+        size_t total = n + align;
+        if (total > (size_t)__MAX_SLAB_BYTES)
+                malloc_alloc::deallocate_aligned(p, n, align);
+        else
+                deallocate(((void **)p)[-1], total);
+}
+
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::allocate_chain(size_t n, size_t count)
+{
+        if (n > (size_t)__MAX_SLAB_BYTES)
+                return malloc_alloc::allocate_chain(n, count);
+
+        obj *head = NULL;
+        obj **tail = &head;
+        size_t index = CLASS_INDEX(n);
+
+        //先从线程缓存或自由链表摘取
+        obj *p;
+        if (threads)
+        {
+                thread_cache& tc = tls_cache;
+                if (!tc.exited)
+                {
+                        if (!tc.registered)
+                                register_thread_cache(tc);
+                        size_t taken = 0;
+                        for (p = tc.free_list[index]; p != NULL && taken < count; p = p->free_list_link)
+                        {
+                                *tail = p;
+                                tail = &p->free_list_link;
+                                ++taken;
+                        }
+                        tc.free_list[index] = p;
+                        tc.length[index].sub(taken);
+                        __ALLOC_STAT(tc.hits[index].add(taken));
+                        count -= taken;
+                }
+        }
+        else
+        {
+                size_t taken = 0;
+                for (p = free_list[index]; p != NULL && taken < count; p = p->free_list_link)
+                {
+                        *tail = p;
+                        tail = &p->free_list_link;
+                        ++taken;
+                }
+                free_list[index] = p;
+                __ALLOC_STAT(stat_hits[index].add(taken));
+                count -= taken;
+        }
+
+        //其余的向中心池成批索取
+        while (count > 0)
+        {
+                int nobjs = count > (size_t)0x7fffffff ? 0x7fffffff : (int)count;
+                p = central_fetch(CLASS_SIZE(index), nobjs);
+                *tail = p;
+                while (p->free_list_link != NULL)
+                        p = p->free_list_link;
+                tail = &p->free_list_link;
+                count -= nobjs;
+        }
+        *tail = NULL;
+        return head;
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::deallocate_chain
+    (void *first, void *last, size_t n, size_t count)
+{
+        if (count == 0)
+                return ;
+        if (n > (size_t)__MAX_SLAB_BYTES)
+        {
+                malloc_alloc::deallocate_chain(first, last, n, count);
+                return ;
+        }
+
+        size_t index = CLASS_INDEX(n);
+        if (threads)
+        {
+                thread_cache& tc = tls_cache;
+                if (!tc.exited && tc.length[index].get() + count <= (size_t)(2 * BATCH_OBJS(n)))
+                {
+                        if (!tc.registered)
+                                register_thread_cache(tc);
+                        ((obj *)last)->free_list_link = tc.free_list[index];
+                        tc.free_list[index] = (obj *)first;
+                        tc.length[index].add(count);
+                }
+                else  //超出线程缓存容量，整条归还中心池
+                        central_release((obj *)first, (obj *)last, CLASS_SIZE(index));
+                return ;
+        }
+
+        ((obj *)last)->free_list_link = free_list[index];
+        free_list[index] = (obj *)first;
+}
+
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::thread_allocate(size_t n)
+{
+        thread_cache& tc = tls_cache;
+        size_t index = CLASS_INDEX(n);
+        if (tc.exited)  //线程正在退出，直接从中心池取
+        {
+                int nobjs = 1;
+                return central_fetch(CLASS_SIZE(index), nobjs);
+        }
+
+        obj *result = tc.free_list[index];
         if (result == NULL)
         {
-                //第n号链表无内存块，则准备重新填充该链表
-                void *r = refill(ROUND_UP(new_size));
-                return r;
+                if (!tc.registered)
+                        register_thread_cache(tc);
+                __ALLOC_STAT(++tc.misses[index]);
+                int nobjs = BATCH_OBJS(n);
+                result = central_fetch(CLASS_SIZE(index), nobjs);
+                tc.length[index].set(nobjs - 1);
         }
-        *my_free_list = result->free_list_link;
+        else
+        {
+                __ALLOC_STAT(++tc.hits[index]);
+                --tc.length[index];
+        }
+        tc.free_list[index] = result->free_list_link;
         return result;
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::thread_deallocate(void *p, size_t n)
+{
+        thread_cache& tc = tls_cache;
+        obj *q = (obj *)p;
+        if (tc.exited)
+        {
+                q->free_list_link = NULL;
+                central_release(q, q, n);
+                return ;
+        }
 
+        if (!tc.registered)
+                register_thread_cache(tc);
+
+        size_t index = CLASS_INDEX(n);
+        q->free_list_link = tc.free_list[index];
+        tc.free_list[index] = q;
+        size_t length = (++tc.length[index]).get();
+        if (length > (size_t)__MAX_CACHED
+            || (n > (size_t)__MAX_BYTES && length > (size_t)(2 * BATCH_OBJS(n))))
+        {
+                //缓存过长，将头部一批区块归还中心池
+                int nobjs = BATCH_OBJS(n);
+                obj *last = q;
+                for (int i = 1; i < nobjs; i++)
+                        last = last->free_list_link;
+                tc.free_list[index] = last->free_list_link;
+                tc.length[index].sub(nobjs);
+                last->free_list_link = NULL;
+                central_release(q, last, n);
+        }
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::flush_thread_cache()
+{
+        if (!threads)
+                return ;
+
+        thread_cache& tc = tls_cache;
+        for (int i = 0; i < __NCLASSES; i++)
+        {
+                obj *first = tc.free_list[i];
+                if (first == NULL)
+                        continue;
+                obj *last = first;
+                while (last->free_list_link != NULL)
+                        last = last->free_list_link;
+                central_release(first, last, CLASS_SIZE(i));
+                tc.free_list[i] = NULL;
+                tc.length[i].set(0);
+        }
 }
 
-template <bool threads>
-void *__default_alloc<threads>::refill(size_t n)
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::register_thread_cache(thread_cache& tc)
 {
+        //线程退出时析构reaper
+        static thread_local thread_cache_reaper reaper;
+        (void)reaper;
+        tc.registered = true;
+        __ALLOC_STAT(register_cache(tc));
+}
+
+template <bool threads, typename ChunkSource>
+typename __default_alloc<threads, ChunkSource>::obj *
+__default_alloc<threads, ChunkSource>::central_fetch(size_t n, int& nobjs)
+{
+        lock guard;
+        __ALLOC_STAT(++stat_refills[CLASS_INDEX(n)]);
+        obj *volatile *my_free_list = free_list + CLASS_INDEX(n);
+        obj *result = *my_free_list;
+        if (result == NULL && n > (size_t)__MAX_BYTES && slab_fill(n))
+                result = *my_free_list;
+        if (result != NULL)  //中心链表有空闲块，摘下至多nobjs块
+        {
+                obj *last = result;
+                int i = 1;
+                for (; i < nobjs && last->free_list_link != NULL; i++)
+                        last = last->free_list_link;
+                *my_free_list = last->free_list_link;
+                last->free_list_link = NULL;
+                nobjs = i;
+                return result;
+        }
+
+        //中心链表为空，直接从内存池切出一批并串成链表
+        __ALLOC_STAT(++stat_chunk_allocs);
+        char *chunk = chunk_alloc(n, nobjs);
+        obj *current_obj = (obj *)chunk;
+        for (int i = 1; i < nobjs; i++)
+        {
+                obj *next_obj = (obj *)((char *)current_obj + n);
+                current_obj->free_list_link = next_obj;
+                current_obj = next_obj;
+        }
+        current_obj->free_list_link = NULL;
+        return (obj *)chunk;
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::central_release(obj *first, obj *last, size_t n)
+{
+        lock guard;
+        obj *volatile *my_free_list = free_list + CLASS_INDEX(n);
+        last->free_list_link = *my_free_list;
+        *my_free_list = first;
+}
+
+template <bool threads, typename ChunkSource>
+void *__default_alloc<threads, ChunkSource>::refill(size_t n)
+{
+        __ALLOC_STAT(++stat_refills[CLASS_INDEX(n)]);
+        if (n > (size_t)__MAX_BYTES)  //slab分级
+        {
+                obj *volatile *my_free_list = free_list + CLASS_INDEX(n);
+                if (!slab_fill(n))
+                        return NULL;
+                obj *result = *my_free_list;
+                *my_free_list = result->free_list_link;
+                return result;
+        }
+
         int nobjs = __NOBJS;
+        __ALLOC_STAT(++stat_chunk_allocs);
         char *chunk = chunk_alloc(n, nobjs);  //从内存池获取内存
         if (nobjs == 1)  //只能分配一块，则直接返回给调用者
                 return chunk;
@@ -245,7 +1104,7 @@ void *__default_alloc<threads>::refill(size_t n)
         for (int i = 1; i < nobjs - 1; i++)  //将剩下的区块添加进链表
         {
                 current_obj = next_obj;
-                next_obj = (obj *)(char *)(next_obj + n);
+                next_obj = (obj *)((char *)next_obj + n);
                 current_obj->free_list_link = next_obj;
         }
 
@@ -256,8 +1115,9 @@ void *__default_alloc<threads>::refill(size_t n)
         return result;
 }
 
-template <bool threads>
-char *__default_alloc<threads>::chunk_alloc(size_t size, int& nobjs)
+//threads为true时，调用者须持有中心池的锁
+template <bool threads, typename ChunkSource>
+char *__default_alloc<threads, ChunkSource>::chunk_alloc(size_t size, int& nobjs)
 {
         size_t total_size = size * nobjs;
         char *result;
@@ -280,19 +1140,21 @@ char *__default_alloc<threads>::chunk_alloc(size_t size, int& nobjs)
         {
                 if (size_left > 0)  //将残余内存分配给其他合适的链表
                 {
+                        __ALLOC_STAT(++stat_fragments);
+                        __ALLOC_STAT(stat_fragment_bytes.add(size_left));
                         obj *volatile *my_free_list = free_list + FREELIST_INDEX(size_left);
                         ((obj *)start_free)->free_list_link = *my_free_list;  //在头部插入
                         *my_free_list = (obj *)start_free;
                 }
 
                 size_t bytes_to_get = 2 * total_size + ROUND_UP(heap_size >> 4);
-                start_free = (char *)malloc(bytes_to_get);
+                start_free = chunk_get(bytes_to_get, false);
                 if (start_free == NULL)  //堆空间不足
                 {
-                        int i;
+                        size_t i;
                         obj *volatile *my_free_list;
                         obj *p;
-                        for (i = size; i < __MAX_BYTES; i++)
+                        for (i = size; i <= (size_t)__MAX_BYTES; i += __ALIGN)
                         {
                                 my_free_list = free_list + FREELIST_INDEX(i);
                                 p = *my_free_list;
@@ -305,48 +1167,523 @@ char *__default_alloc<threads>::chunk_alloc(size_t size, int& nobjs)
                                 }
                         }
                         end_free = NULL;
-                        //调用第一级配置器
-                        start_free = (char *)malloc_alloc::allocate(bytes_to_get);
+                        //归还完全空闲的大块，让系统把它们合并后再试一次
+                        if (trim_locked() != 0)
+                                start_free = chunk_get(bytes_to_get, false);
+                        //调用第一级配置器，依次经过内存压力回调和oom处理函数
+                        if (start_free == NULL)
+                                start_free = chunk_get(bytes_to_get, true);
                 }
                 heap_size += bytes_to_get;
-                end_free = start_free + heap_size;
+                end_free = start_free + bytes_to_get;
                 return chunk_alloc(size, nobjs);
         }
 }
 
+template <bool threads, typename ChunkSource>
+char *__default_alloc<threads, ChunkSource>::chunk_get(size_t& bytes, bool use_malloc_alloc)
+{
+        size_t total = sizeof(chunk_header) + bytes;
+        chunk_header *h;
+        if (use_malloc_alloc)  //失败时由第一级配置器处理
+                h = (chunk_header *)malloc_alloc::allocate(total);
+        else
+                h = (chunk_header *)ChunkSource::allocate(total);
+        if (h == NULL)
+                return NULL;
+
+        //第一次取得大块时登记内存压力回调
+        static bool registered = false;
+        if (!registered)
+        {
+                registered = true;
+                memory_pressure::add_handler(pressure_handler, NULL);
+        }
+
+        bytes = (total - sizeof(chunk_header)) & ~(size_t)(__ALIGN - 1);
+        h->size = bytes;
+        h->total = total;
+        h->from_malloc_alloc = use_malloc_alloc;
+        h->next = chunk_list;
+        chunk_list = h;
+        ++chunk_count;
+        return (char *)(h + 1);
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::chunk_put(chunk_header *h)
+{
+        if (h->from_malloc_alloc)
+                malloc_alloc::deallocate(h, h->total);
+        else
+                ChunkSource::deallocate(h, h->total);
+}
+
+//threads为true时，调用者须持有中心池的锁
+template <bool threads, typename ChunkSource>
+bool __default_alloc<threads, ChunkSource>::slab_fill(size_t n)
+{
+        size_t bytes = n * __SLAB_MIN_OBJS;
+        bytes = (bytes + __SLAB_PAGE - 1) & ~(size_t)(__SLAB_PAGE - 1);
+        bytes = bytes / n * n;
+
+        char *slab = chunk_get(bytes, false);
+        if (slab == NULL && trim_locked() != 0)
+                slab = chunk_get(bytes, false);
+        if (slab == NULL)
+                slab = chunk_get(bytes, true);
+        if (slab == NULL)
+                return false;
+
+        //ChunkSource可能给出更多空间，尽量切分；slab只登记实际切分的字节数，
+        //整块空闲时trim才能识别
+        size_t nobjs = bytes / n;
+        ((chunk_header *)slab - 1)->size = nobjs * n;
+        heap_size += nobjs * n;
+        __ALLOC_STAT(++stat_slab_fills);
+
+        obj *volatile *my_free_list = free_list + CLASS_INDEX(n);
+        for (size_t i = nobjs; i > 0; i--)  //逆序插入，使链表按地址递增
+        {
+                obj *current_obj = (obj *)(slab + (i - 1) * n);
+                current_obj->free_list_link = *my_free_list;
+                *my_free_list = current_obj;
+        }
+        return true;
+}
+
+template <bool threads, typename ChunkSource>
+int __default_alloc<threads, ChunkSource>::chunk_compare(const void *a, const void *b)
+{
+        size_t x = (size_t)*(chunk_header *const *)a;
+        size_t y = (size_t)*(chunk_header *const *)b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+template <bool threads, typename ChunkSource>
+typename __default_alloc<threads, ChunkSource>::chunk_header *
+__default_alloc<threads, ChunkSource>::chunk_find
+    (chunk_header **chunks, size_t n, const char *p)
+{
+        if (chunks == NULL)
+        {
+                chunk_header *h = chunk_list;
+                for (; h != NULL; h = h->next)
+                {
+                        const char *start = (const char *)(h + 1);
+                        if ((size_t)start <= (size_t)p && (size_t)p < (size_t)(start + h->size))
+                                break;
+                }
+                return h;
+        }
+
+        size_t lo = 0, hi = n;
+        while (hi - lo > 1)  //最后一个起始地址不大于p的大块
+        {
+                size_t mid = lo + (hi - lo) / 2;
+                if ((size_t)chunks[mid] <= (size_t)p)
+                        lo = mid;
+                else
+                        hi = mid;
+        }
+        return chunks[lo];
+}
+
+template <bool threads, typename ChunkSource>
+size_t __default_alloc<threads, ChunkSource>::pressure_handler(size_t, void *)
+{
+        flush_thread_cache();
+        lock guard;
+        return trim_locked();
+}
+
+template <bool threads, typename ChunkSource>
+size_t __default_alloc<threads, ChunkSource>::trim()
+{
+        flush_thread_cache();
+        lock guard;
+        return trim_locked();
+}
+
+//统计每个大块中空闲区块与内存池余量的字节数，等于大块可用字节数即为完全空闲
+template <bool threads, typename ChunkSource>
+size_t __default_alloc<threads, ChunkSource>::trim_locked()
+{
+        if (chunk_count == 0)
+                return 0;
+
+        //排序数组用于二分查找，内存不足分配失败时退化为顺序查找
+        size_t n = chunk_count;
+        chunk_header **chunks = (chunk_header **)malloc(n * sizeof(chunk_header *));
+        chunk_header *h;
+        size_t k = 0;
+        for (h = chunk_list; h != NULL; h = h->next)
+        {
+                h->free_bytes = 0;
+                if (chunks != NULL)
+                        chunks[k++] = h;
+        }
+        if (chunks != NULL)
+                qsort(chunks, n, sizeof(chunk_header *), chunk_compare);
+
+        int i;
+        obj *p;
+        for (i = 0; i < __NCLASSES; i++)
+                for (p = free_list[i]; p != NULL; p = p->free_list_link)
+                        chunk_find(chunks, n, (char *)p)->free_bytes += CLASS_SIZE(i);
+        if (start_free != end_free)
+                chunk_find(chunks, n, start_free)->free_bytes += end_free - start_free;
+
+        size_t releasable = 0;
+        for (h = chunk_list; h != NULL; h = h->next)
+                releasable += (h->free_bytes == h->size);
+
+        size_t released = 0;
+        if (releasable != 0)
+        {
+                //从自由链表中摘除位于待释放大块中的区块
+                for (i = 0; i < __NCLASSES; i++)
+                {
+                        obj *volatile *link = free_list + i;
+                        while ((p = *link) != NULL)
+                        {
+                                h = chunk_find(chunks, n, (char *)p);
+                                if (h->free_bytes == h->size)
+                                        *link = p->free_list_link;
+                                else
+                                        link = &p->free_list_link;
+                        }
+                }
+                if (start_free != end_free)
+                {
+                        h = chunk_find(chunks, n, start_free);
+                        if (h->free_bytes == h->size)
+                                start_free = end_free = NULL;
+                }
+
+                chunk_header **link = &chunk_list;
+                while (*link != NULL)
+                {
+                        h = *link;
+                        if (h->free_bytes == h->size)
+                        {
+                                *link = h->next;
+                                heap_size -= h->size;
+                                released += h->total;
+                                --chunk_count;
+                                chunk_put(h);
+                        }
+                        else
+                                link = &h->next;
+                }
+        }
+
+        free(chunks);
+        return released;
+}
+
+#ifdef __SIMSTL_ALLOC_STATS
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::register_cache(thread_cache& tc)
+{
+        lock guard;
+        tc.prev_cache = NULL;
+        tc.next_cache = cache_list;
+        if (cache_list != NULL)
+                cache_list->prev_cache = &tc;
+        cache_list = &tc;
+}
+
+//线程退出时把计数并入全局计数
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::unregister_cache(thread_cache& tc)
+{
+        lock guard;
+        for (int i = 0; i < __NCLASSES; i++)
+        {
+                stat_hits[i].add(tc.hits[i].get());
+                stat_misses[i].add(tc.misses[i].get());
+        }
+        if (tc.prev_cache != NULL)
+                tc.prev_cache->next_cache = tc.next_cache;
+        else
+                cache_list = tc.next_cache;
+        if (tc.next_cache != NULL)
+                tc.next_cache->prev_cache = tc.prev_cache;
+}
+#endif
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::get_stats(alloc_stats& stats)
+{
+        lock guard;
+        for (int i = 0; i < __NCLASSES; i++)
+        {
+                alloc_class_stats& c = stats.classes[i];
+                c.block_size = CLASS_SIZE(i);
+                c.hits = c.misses = c.refills = c.free_blocks = 0;
+                __ALLOC_STAT(c.hits = stat_hits[i].get());
+                __ALLOC_STAT(c.misses = stat_misses[i].get());
+                __ALLOC_STAT(c.refills = stat_refills[i].get());
+                for (obj *p = free_list[i]; p != NULL; p = p->free_list_link)
+                        ++c.free_blocks;
+        }
+#ifdef __SIMSTL_ALLOC_STATS
+        for (thread_cache *tc = cache_list; tc != NULL; tc = tc->next_cache)
+        {
+                for (int i = 0; i < __NCLASSES; i++)
+                {
+                        stats.classes[i].hits += tc->hits[i].get();
+                        stats.classes[i].misses += tc->misses[i].get();
+                        stats.classes[i].free_blocks += tc->length[i].get();
+                }
+        }
+#endif
+        for (int i = 0; i < __NCLASSES; i++)
+                stats.classes[i].free_bytes = stats.classes[i].free_blocks * CLASS_SIZE(i);
+
+        stats.heap_size = heap_size;
+        stats.chunk_count = chunk_count;
+        stats.chunk_allocs = stats.slab_fills = 0;
+        stats.fragments = stats.fragment_bytes = 0;
+        __ALLOC_STAT(stats.chunk_allocs = stat_chunk_allocs.get());
+        __ALLOC_STAT(stats.slab_fills = stat_slab_fills.get());
+        __ALLOC_STAT(stats.fragments = stat_fragments.get());
+        __ALLOC_STAT(stats.fragment_bytes = stat_fragment_bytes.get());
+        stats.oom_calls = malloc_alloc::oom_calls();
+}
+
+template <bool threads, typename ChunkSource>
+void __default_alloc<threads, ChunkSource>::dump_stats(std::ostream& os)
+{
+        alloc_stats stats;
+        get_stats(stats);
+        os << "heap_size " << stats.heap_size
+           << " chunks " << stats.chunk_count
+           << " chunk_allocs " << stats.chunk_allocs
+           << " slab_fills " << stats.slab_fills
+           << " fragments " << stats.fragments
+           << " fragment_bytes " << stats.fragment_bytes
+           << " oom_calls " << stats.oom_calls << '\n';
+        for (int i = 0; i < __NCLASSES; i++)
+        {
+                const alloc_class_stats& c = stats.classes[i];
+                if (c.hits == 0 && c.misses == 0 && c.free_blocks == 0)
+                        continue;
+                os << "class " << c.block_size
+                   << " hits " << c.hits
+                   << " misses " << c.misses
+                   << " refills " << c.refills
+                   << " free_blocks " << c.free_blocks
+                   << " free_bytes " << c.free_bytes << '\n';
+        }
+}
+
 #ifdef __USE_MALLOC
-typedef malloc_alloc alloc
+typedef malloc_alloc alloc;
+#elif defined(__SIMSTL_THREADS)
+typedef __default_alloc<true> alloc;
 #else
 typedef __default_alloc<false> alloc;
 #endif
 
+#if defined(__unix__) || defined(__APPLE__)
+//大块内存来自2MB大页的内存池
+typedef __default_alloc<false, mmap_chunk_source> huge_page_alloc;
+#endif
+
+//T的对齐要求超过配置器保证的8字节时（SIMD类型、按缓存行对齐的结构），
+//自动改用allocate_aligned。
+//第一个参数为Alloc&的版本通过配置器对象调用，供保存了配置器的容器使用，Alloc可以有状态；
+//其余版本用于只有静态函数的配置器
 template <typename T, typename Alloc>
 class simple_alloc
 {
+private:
+        enum {__ALIGN = 8};
+
+        template <bool over_aligned, int dummy = 0>
+        struct __align_tag { typedef __false_type type; };
+        template <int dummy>
+        struct __align_tag<true, dummy> { typedef __true_type type; };
+
+        //按标签分派，Alloc只需提供T实际用到的那一组函数
+        typedef typename __align_tag<(alignof(T) > __ALIGN)>::type over_aligned;
+
+        static void *raw_allocate(Alloc& a, size_t bytes, __true_type)
+        {
+                return a.allocate_aligned(bytes, alignof(T));
+        }
+
+        static void *raw_allocate(Alloc& a, size_t bytes, __false_type)
+        {
+                return a.allocate(bytes);
+        }
+
+        static void raw_deallocate(Alloc& a, void *p, size_t bytes, __true_type)
+        {
+                a.deallocate_aligned(p, bytes, alignof(T));
+        }
+
+        static void raw_deallocate(Alloc& a, void *p, size_t bytes, __false_type)
+        {
+                a.deallocate(p, bytes);
+        }
+
+        static T *raw_reallocate(Alloc& a, T *p, size_t old_n, size_t new_n, __true_type)
+        {
+                T *result = allocate(a, new_n);
+                memcpy((void *)result, (void *)p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+                deallocate(a, p, old_n);
+                return result;
+        }
+
+        static T *raw_reallocate(Alloc& a, T *p, size_t old_n, size_t new_n, __false_type)
+        {
+                return (T*)a.reallocate(p, old_n * sizeof(T), new_n * sizeof(T));
+        }
+
+        //逐个对齐分配后串起
+        static T *raw_allocate_chain(Alloc& a, size_t count, __true_type)
+        {
+                T *head = 0;
+                while (count-- > 0)
+                {
+                        T *p = allocate(a, 1);
+                        chain_link(p, head);
+                        head = p;
+                }
+                return head;
+        }
+
+        static T *raw_allocate_chain(Alloc& a, size_t count, __false_type)
+        {
+                return (T*)a.allocate_chain(sizeof(T), count);
+        }
+
+        static void raw_deallocate_chain(Alloc& a, T *first, T *, size_t count, __true_type)
+        {
+                while (count-- > 0)
+                {
+                        T *next = chain_next(first);
+                        deallocate(a, first, 1);
+                        first = next;
+                }
+        }
+
+        static void raw_deallocate_chain(Alloc& a, T *first, T *last, size_t count, __false_type)
+        {
+                a.deallocate_chain(first, last, sizeof(T), count);
+        }
+
 public:
+        static T *allocate(Alloc& a, size_t n)
+        {
+                if (n == 0)
+                        return 0;
+                return (T*)raw_allocate(a, n * sizeof(T), over_aligned());
+        }
+
         static T *allocate(size_t n)
         {
-                return n == 0 ? 0 : (T*)Alloc::allocate(n * sizeof(T));
+                Alloc a;
+                return allocate(a, n);
         }
 
-        static T *alocate(void)
+        static T *allocate(void)
         {
-                return (T*)Alloc::allocate(sizeof(T));
+                return allocate(1);
+        }
+
+        //申请n个T时配置器实际能容纳的T的个数
+        static size_t good_size(size_t n)
+        {
+                return Alloc::good_size(n * sizeof(T)) / sizeof(T);
+        }
+
+        static void deallocate(Alloc& a, T *p, size_t n)
+        {
+                if (n == 0)
+                        return ;
+                raw_deallocate(a, p, n * sizeof(T), over_aligned());
         }
 
         static void deallocate(T *p, size_t n)
         {
-                if (n != 0)
-                        Alloc::deallocate(p, n * sizeof(T));
+                Alloc a;
+                deallocate(a, p, n);
         }
 
         static void deallocate(T *p)
         {
-                Alloc::deallocate(p, sizeof(T));
+                deallocate(p, 1);
+        }
+
+        //只适用于可平凡搬移的T
+        static T *reallocate(Alloc& a, T *p, size_t old_n, size_t new_n)
+        {
+                if (old_n == 0)
+                        return allocate(a, new_n);
+                if (new_n == 0)
+                {
+                        deallocate(a, p, old_n);
+                        return 0;
+                }
+                return raw_reallocate(a, p, old_n, new_n, over_aligned());
+        }
+
+        static T *reallocate(T *p, size_t old_n, size_t new_n)
+        {
+                Alloc a;
+                return reallocate(a, p, old_n, new_n);
+        }
+
+        //一次分配count个T，用chain_next遍历
+        static T *allocate_chain(Alloc& a, size_t count)
+        {
+                if (count == 0)
+                        return 0;
+                return raw_allocate_chain(a, count, over_aligned());
         }
+
+        static T *allocate_chain(size_t count)
+        {
+                Alloc a;
+                return allocate_chain(a, count);
+        }
+
+        //归还count个T组成的链，调用者先用chain_link把它们依次串起
+        static void deallocate_chain(Alloc& a, T *first, T *last, size_t count)
+        {
+                if (count == 0)
+                        return ;
+                raw_deallocate_chain(a, first, last, count, over_aligned());
+        }
+
+        static void deallocate_chain(T *first, T *last, size_t count)
+        {
+                Alloc a;
+                deallocate_chain(a, first, last, count);
+        }
+
+        static T *chain_next(T *p) { return (T*)__chain_next(p); }
+        static void chain_link(T *p, T *next) { __chain_link(p, next); }
 };
 
 
+//容器保存的配置器。只有静态函数的配置器是空类，借空基类优化不占空间；
+//有状态的配置器随容器复制、移动和交换
+template <typename Alloc>
+class __alloc_holder : private Alloc
+{
+public:
+        __alloc_holder() {}
+        explicit __alloc_holder(const Alloc& a) : Alloc(a) {}
+
+        Alloc& get_alloc() { return *this; }
+        const Alloc& get_alloc() const { return *this; }
+};
+
 }
 
 #endif
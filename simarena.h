@@ -0,0 +1,270 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include "simalloc.h"
+
+namespace SimSTL {
+
+
+//单调增长的内存区：分配只移动指针，deallocate什么也不做，
+//release或析构时一次性归还全部内存
+class monotonic_arena
+{
+public:
+        explicit monotonic_arena(size_t block_size = 4096)
+            : head(NULL), cur(NULL), end(NULL), next_size(block_size) {}
+
+        ~monotonic_arena() { release(); }
+
+        void *allocate(size_t n)
+        {
+                n = ROUND_UP(n);
+                if ((size_t)(end - cur) < n)
+                        new_block(n);
+                char *result = cur;
+                cur += n;
+                return result;
+        }
+
+        void deallocate(void *, size_t) {}
+
+        static size_t good_size(size_t n) { return ROUND_UP(n); }
+
+        //align为2的幂
+        void *allocate_aligned(size_t n, size_t align)
+        {
+                if (align <= (size_t)__ALIGN)
+                        return allocate(n);
+                n = ROUND_UP(n);
+                char *result = ALIGN_UP(cur, align);
+                if (cur == NULL || result > end || (size_t)(end - result) < n)
+                {
+                        new_block(n + align);
+                        result = ALIGN_UP(cur, align);
+                }
+                cur = result + n;
+                return result;
+        }
+
+        void deallocate_aligned(void *, size_t, size_t) {}
+
+        //count个区块连续切出后串成链表
+        void *allocate_chain(size_t n, size_t count)
+        {
+                if (count == 0)
+                        return NULL;
+                n = ROUND_UP(n);
+                char *p = (char *)allocate(n * count);
+                for (size_t i = 0; i < count - 1; i++)
+                        __chain_link(p + i * n, p + (i + 1) * n);
+                __chain_link(p + (count - 1) * n, NULL);
+                return p;
+        }
+
+        //p是最近一次分配的区块且空间足够时原地伸缩，否则分配新区块并复制
+        void *reallocate(void *p, size_t old_size, size_t new_size)
+        {
+                old_size = ROUND_UP(old_size);
+                new_size = ROUND_UP(new_size);
+                if ((char *)p + old_size == cur
+                    && (size_t)(end - (char *)p) >= new_size)
+                {
+                        cur = (char *)p + new_size;
+                        return p;
+                }
+                void *result = allocate(new_size);
+                memcpy(result, p, old_size < new_size ? old_size : new_size);
+                return result;
+        }
+
+        //归还全部内存
+        void release()
+        {
+                while (head != NULL)
+                {
+                        block *next = head->next;
+                        malloc_alloc::deallocate(head, head->size);
+                        head = next;
+                }
+                cur = end = NULL;
+        }
+
+private:
+        enum {__ALIGN = 8};
+
+        //单个内存块的上限，超过的请求单独成块
+        enum {__MAX_BLOCK = 1024 * 1024};
+
+        struct block
+        {
+                block *next;
+                size_t size;
+        };
+
+        static size_t ROUND_UP(size_t bytes)
+        {
+                return ((bytes + __ALIGN - 1) & ~(size_t)(__ALIGN - 1));
+        }
+
+        static char *ALIGN_UP(char *p, size_t align)
+        {
+                return (char *)(((size_t)p + align - 1) & ~(align - 1));
+        }
+
+        //新块大小按2倍增长，直到__MAX_BLOCK
+        void new_block(size_t n)
+        {
+                size_t size = sizeof(block) + n;
+                if (size < next_size)
+                        size = next_size;
+                if (next_size < (size_t)__MAX_BLOCK)
+                        next_size *= 2;
+
+                block *b = (block *)malloc_alloc::allocate(size);
+                b->next = head;
+                b->size = size;
+                head = b;
+                cur = (char *)(b + 1);
+                end = (char *)b + size;
+        }
+
+        monotonic_arena(const monotonic_arena&);
+        monotonic_arena& operator=(const monotonic_arena&);
+
+private:
+        block *head;
+        char *cur;
+        char *end;
+        size_t next_size;
+};
+
+
+//从当前线程的scope中分配的配置器，可作为simple_alloc或容器的Alloc参数。
+//scope结束时其中分配的内存一次性归还，使用该配置器的容器必须在scope之内析构：
+//      {
+//              arena_alloc::scope s;
+//              list<int, arena_alloc> l;
+//              vector<int, arena_alloc> v;
+//              ...
+//      }
+//配置器不记得容器属于哪个scope，所以每个线程同一时刻只能有一个scope：
+//否则外层scope中的容器在内层scope中扩容时会从内层分配，内层结束后就悬空了。
+//需要嵌套或跨越scope的内存区时使用arena_ref_alloc
+template <int inst>
+class __arena_alloc
+{
+public:
+        class scope
+        {
+        public:
+                explicit scope(size_t block_size = 4096) : arena(block_size)
+                {
+                        assert(current() == NULL && "arena_alloc::scope cannot be nested");
+                        current() = &arena;
+                }
+
+                ~scope() { current() = NULL; }
+
+                monotonic_arena& get_arena() { return arena; }
+
+        private:
+                scope(const scope&);
+                scope& operator=(const scope&);
+
+        private:
+                monotonic_arena arena;
+        };
+
+        static void *allocate(size_t n)
+        {
+                assert(current() != NULL && "arena_alloc used outside of a scope");
+                return current()->allocate(n);
+        }
+
+        static void deallocate(void *, size_t) {}
+
+        static size_t good_size(size_t n) { return monotonic_arena::good_size(n); }
+
+        static void *allocate_aligned(size_t n, size_t align)
+        {
+                assert(current() != NULL && "arena_alloc used outside of a scope");
+                return current()->allocate_aligned(n, align);
+        }
+
+        static void deallocate_aligned(void *, size_t, size_t) {}
+
+        static void *allocate_chain(size_t n, size_t count)
+        {
+                assert(current() != NULL && "arena_alloc used outside of a scope");
+                return current()->allocate_chain(n, count);
+        }
+
+        static void deallocate_chain(void *, void *, size_t, size_t) {}
+
+        static void *reallocate(void *p, size_t old_size, size_t new_size)
+        {
+                assert(current() != NULL && "arena_alloc used outside of a scope");
+                return current()->reallocate(p, old_size, new_size);
+        }
+
+private:
+        static monotonic_arena *&current()
+        {
+                static thread_local monotonic_arena *arena = NULL;
+                return arena;
+        }
+};
+
+typedef __arena_alloc<0> arena_alloc;
+
+
+//指向某个monotonic_arena的有状态配置器，保存在容器中，不依赖线程局部的scope，
+//多个容器可以共享同一个内存区：
+//      monotonic_arena arena;
+//      vector<int, arena_ref_alloc> v((arena_ref_alloc(arena)));
+//      list<int, arena_ref_alloc> l((arena_ref_alloc(arena)));
+class arena_ref_alloc
+{
+public:
+        explicit arena_ref_alloc(monotonic_arena& a) : arena(&a) {}
+
+        void *allocate(size_t n) { return arena->allocate(n); }
+        void deallocate(void *, size_t) {}
+
+        void *allocate_aligned(size_t n, size_t align)
+        {
+                return arena->allocate_aligned(n, align);
+        }
+
+        void deallocate_aligned(void *, size_t, size_t) {}
+
+        void *allocate_chain(size_t n, size_t count)
+        {
+                return arena->allocate_chain(n, count);
+        }
+
+        void deallocate_chain(void *, void *, size_t, size_t) {}
+
+        void *reallocate(void *p, size_t old_size, size_t new_size)
+        {
+                return arena->reallocate(p, old_size, new_size);
+        }
+
+        static size_t good_size(size_t n) { return monotonic_arena::good_size(n); }
+
+        monotonic_arena& get_arena() const { return *arena; }
+
+        bool operator==(const arena_ref_alloc& x) const { return arena == x.arena; }
+        bool operator!=(const arena_ref_alloc& x) const { return arena != x.arena; }
+
+private:
+        monotonic_arena *arena;
+};
+
+
+}
+
+#endif
@@ -2,17 +2,31 @@
 #define _CONSTRUCT_H_H
 
 #include <new> //for 定位new
+#include <utility> //for std::forward
 #include "simtype_traits.h"
 #include "simiterator_base.h"  //for value_type()
 
 namespace SimSTL {
 
 
-template <typename T1, typename T2>
-inline void construct(T1 *p, const T2& value)
+//以args构造对象，args可以是右值或多个构造参数
+template <typename T1, typename... Args>
+inline void construct(T1 *p, Args&&... args)
 {
         //定位new
-        new (p) T1(value);
+        new (p) T1(std::forward<Args>(args)...);
+}
+
+//resize等接口的标记参数：新元素默认初始化而不是值初始化，
+//有trivial默认构造函数的类型（char、float等）不清零
+struct default_init_t {};
+static const default_init_t default_init = default_init_t();
+
+//默认初始化
+template <typename T>
+inline void construct_default(T *p)
+{
+        new ((void *)p) T;
 }
 
 //destroy()第一版本，接受一个指针
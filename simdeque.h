@@ -0,0 +1,846 @@
+#ifndef _MINISTL_DEQUE_H_
+#define _MINISTL_DEQUE_H_
+
+#include "simiterator.h"
+#include "simalloc.h"
+#include "simalgobase.h"
+#include "simconstruct.h"
+#include "simuninitialized.h"
+#include <cstddef>
+#include <utility> //for std::move, std::forward
+
+namespace SimSTL {
+
+
+//每个缓冲区容纳的元素个数，元素不超过512字节时缓冲区为512字节
+inline size_t __deque_buf_size(size_t sz)
+{
+        return sz < 512 ? size_t(512 / sz) : size_t(1);
+}
+
+//deque的中控器：map依次存放各缓冲区的地址。
+//缓冲区按编号node访问，编号为node的缓冲区位于map[node - base]，
+//map重新配置时只改变base，已有缓冲区的编号不变
+template <typename T>
+struct __deque_map
+{
+        T               **map;
+        size_t          map_size;
+        ptrdiff_t       base;
+
+        T **slot(ptrdiff_t node) const { return map + (node - base); }
+};
+
+// deque迭代器
+//保存缓冲区编号而不是map中的位置，map重新配置后迭代器仍然有效
+template <typename T, typename Ref, typename Ptr>
+struct __deque_iterator
+{
+        typedef __deque_iterator<T, T&, T*>             iterator;
+        typedef __deque_iterator<T, const T&, const T*> const_iterator;
+        typedef __deque_iterator<T, Ref, Ptr>           self;
+
+        typedef random_access_iterator_tag iterator_category;
+        typedef T               value_type;
+        typedef ptrdiff_t       difference_type;
+        typedef Ptr             pointer;
+        typedef Ref             reference;
+        typedef size_t          size_type;
+
+        T *cur;         //当前元素
+        T *first;       //所在缓冲区的头
+        T *last;        //所在缓冲区的尾（含备用空间）
+        difference_type node;   //所在缓冲区的编号
+        const __deque_map<T> *ctrl;
+
+        static difference_type buffer_size() { return difference_type(__deque_buf_size(sizeof(T))); }
+
+        // constructor
+        __deque_iterator() : cur(0), first(0), last(0), node(0), ctrl(0) {}
+        __deque_iterator(const __deque_iterator&) = default;
+        __deque_iterator& operator=(const __deque_iterator&) = default;
+        //iterator转换为const_iterator，只接受元素指针为T*的迭代器
+        template <typename R>
+        __deque_iterator(const __deque_iterator<T, R, T*>& x)
+            : cur(x.cur), first(x.first), last(x.last), node(x.node), ctrl(x.ctrl) {}
+
+        //跳到编号为new_node的缓冲区，cur由调用者设置
+        void set_node(difference_type new_node)
+        {
+                node = new_node;
+                first = *ctrl->slot(new_node);
+                last = first + buffer_size();
+        }
+
+        reference operator*() const { return *cur; }
+        pointer operator->() const { return &(operator*()); }
+
+        difference_type operator-(const self& x) const
+        {
+                return buffer_size() * (node - x.node - 1) + (cur - first) + (x.last - x.cur);
+        }
+
+        self& operator++()
+        {
+                ++cur;
+                if (cur == last)
+                {
+                        set_node(node + 1);
+                        cur = first;
+                }
+                return *this;
+        }
+        self operator++(int)
+        {
+                self tmp = *this;
+                ++*this;
+                return tmp;
+        }
+        self& operator--()
+        {
+                if (cur == first)
+                {
+                        set_node(node - 1);
+                        cur = last;
+                }
+                --cur;
+                return *this;
+        }
+        self operator--(int)
+        {
+                self tmp = *this;
+                --*this;
+                return tmp;
+        }
+
+        self& operator+=(difference_type n)
+        {
+                difference_type offset = n + (cur - first);
+                if (offset >= 0 && offset < buffer_size())
+                        cur += n;  //仍在同一缓冲区
+                else
+                {
+                        difference_type node_offset = offset > 0 ? offset / buffer_size()
+                                                                 : -((-offset - 1) / buffer_size()) - 1;
+                        set_node(node + node_offset);
+                        cur = first + (offset - node_offset * buffer_size());
+                }
+                return *this;
+        }
+        self operator+(difference_type n) const
+        {
+                self tmp = *this;
+                return tmp += n;
+        }
+        self& operator-=(difference_type n) { return *this += -n; }
+        self operator-(difference_type n) const
+        {
+                self tmp = *this;
+                return tmp -= n;
+        }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        bool operator==(const self& x) const { return cur == x.cur; }
+        bool operator!=(const self& x) const { return cur != x.cur; }
+        bool operator<(const self& x) const
+        {
+                return node == x.node ? cur < x.cur : node < x.node;
+        }
+        bool operator>(const self& x) const { return x < *this; }
+        bool operator<=(const self& x) const { return !(x < *this); }
+        bool operator>=(const self& x) const { return !(*this < x); }
+};
+
+// deque
+//元素分段存放在固定大小的缓冲区中，缓冲区和map都向Alloc配置。
+//两端的push和pop为O(1)，扩充时只重新配置map，元素不会被搬移，
+//在两端放入元素后原有的迭代器和引用仍然有效。
+//迭代器指向deque对象中的中控器，swap和移动之后原来的迭代器失效
+template <typename T, typename Alloc = alloc>
+class deque : private __alloc_holder<Alloc>
+{
+public:
+        // 基础类型
+        typedef T                       value_type;
+        typedef ptrdiff_t               difference_type;
+        typedef value_type*             pointer;
+        typedef const value_type*       const_pointer;
+        typedef value_type&             reference;
+        typedef const value_type&       const_reference;
+        typedef size_t                  size_type;
+
+        // 空间配置器
+        typedef simple_alloc<T, Alloc>  data_allocator;
+        typedef simple_alloc<T*, Alloc> map_allocator;
+        typedef Alloc allocator_type;
+
+        allocator_type get_allocator() const { return this->get_alloc(); }
+
+public:
+        // 迭代器
+        typedef __deque_iterator<T, T&, T*>             iterator;
+        typedef __deque_iterator<T, const T&, const T*> const_iterator;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+
+private:
+        typedef __alloc_holder<Alloc> alloc_holder;
+        typedef T** map_pointer;
+
+        enum { initial_map_size = 8 };
+
+        iterator        start;
+        iterator        finish;
+        __deque_map<T>  ctrl;
+
+private:
+        // 内部操作
+        static size_type buffer_size() { return __deque_buf_size(sizeof(T)); }
+
+        pointer allocate_node() { return data_allocator::allocate(this->get_alloc(), buffer_size()); }
+        void deallocate_node(pointer p) { data_allocator::deallocate(this->get_alloc(), p, buffer_size()); }
+
+        //配置map和容纳num_elements个元素所需的缓冲区，start和finish指向这段未初始化的空间
+        void create_map_and_nodes(size_type num_elements);
+        void destroy_map_and_nodes();
+
+        //map两端至少还能再放nodes_to_add个缓冲区
+        void reserve_map_at_back(size_type nodes_to_add = 1)
+        {
+                if (nodes_to_add + 1 > ctrl.map_size - (ctrl.slot(finish.node) - ctrl.map))
+                        reallocate_map(nodes_to_add, false);
+        }
+        void reserve_map_at_front(size_type nodes_to_add = 1)
+        {
+                if (nodes_to_add > size_type(ctrl.slot(start.node) - ctrl.map))
+                        reallocate_map(nodes_to_add, true);
+        }
+        void reallocate_map(size_type nodes_to_add, bool add_at_front);
+
+        //在前端或尾端再配置足以容纳n个元素的缓冲区，返回新的start或finish
+        iterator reserve_elements_at_front(size_type n);
+        iterator reserve_elements_at_back(size_type n);
+        void free_nodes(difference_type first_node, difference_type last_node);
+
+        template <typename... Args>
+        void emplace_back_aux(Args&&... args);
+        template <typename... Args>
+        void emplace_front_aux(Args&&... args);
+        void pop_back_aux();
+        void pop_front_aux();
+
+        void fill_initialize(size_type n, const T& value);
+
+        template <typename Integer>
+        void initialize_dispatch(Integer n, Integer value, __true_type)
+        {
+                fill_initialize(size_type(n), value);
+        }
+
+        template <typename InputIterator>
+        void initialize_dispatch(InputIterator first, InputIterator last, __false_type);
+
+        template <typename Integer>
+        void insert_dispatch(iterator position, Integer n, Integer x, __true_type)
+        {
+                insert(position, size_type(n), T(x));
+        }
+
+        template <typename InputIterator>
+        void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+        {
+                for (; first != last; ++first, ++position)
+                        position = insert(position, *first);
+        }
+
+        //只移动指针的swap，不交换配置器
+        void swap_data(deque& x);
+
+public:
+        deque() { create_map_and_nodes(0); }
+
+        explicit deque(const allocator_type& a) : alloc_holder(a) { create_map_and_nodes(0); }
+
+        explicit deque(size_type n, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initialize(n, T()); }
+
+        deque(size_type n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initialize(n, value); }
+
+        deque(int n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initialize(n, value); }
+
+        deque(long n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initialize(n, value); }
+
+        deque(const deque& x) : alloc_holder(x.get_alloc())
+        {
+                create_map_and_nodes(x.size());
+                try {
+                        SimSTL::uninitialized_copy(x.begin(), x.end(), start);
+                }
+                catch(...) {
+                        destroy_map_and_nodes();
+                        throw;
+                }
+        }
+
+        //接管x的map和缓冲区，x重新配置一个空的map
+        deque(deque&& x) : alloc_holder(x.get_alloc())
+        {
+                create_map_and_nodes(0);
+                swap_data(x);
+        }
+
+        template <typename InputIterator>
+        deque(InputIterator first, InputIterator last, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                initialize_dispatch(first, last, integral());
+        }
+
+        ~deque()
+        {
+                SimSTL::destroy(start, finish);
+                destroy_map_and_nodes();
+        }
+
+        deque& operator=(const deque& x)
+        {
+                if (this != &x)
+                {
+                        deque tmp(x);
+                        swap(tmp);
+                }
+                return *this;
+        }
+
+        deque& operator=(deque&& x)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        SimSTL::swap(this->get_alloc(), x.get_alloc());
+                        swap_data(x);
+                }
+                return *this;
+        }
+
+        void swap(deque& x)
+        {
+                SimSTL::swap(this->get_alloc(), x.get_alloc());
+                swap_data(x);
+        }
+
+public:
+        iterator begin() { return start; }
+        iterator end() { return finish; }
+        const_iterator begin() const { return start; }
+        const_iterator end() const { return finish; }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        size_type size() const { return size_type(finish - start); }
+        bool empty() const { return finish == start; }
+        reference operator[](size_type n) { return start[difference_type(n)]; }
+        const_reference operator[](size_type n) const { return start[difference_type(n)]; }
+
+        reference front() { return *start; }
+        const_reference front() const { return *start; }
+        reference back() { return *(finish - 1); }
+        const_reference back() const { return *(finish - 1); }
+
+public:
+        void push_back(const T& val) { emplace_back(val); }
+        void push_back(T&& val) { emplace_back(std::move(val)); }
+        void push_front(const T& val) { emplace_front(val); }
+        void push_front(T&& val) { emplace_front(std::move(val)); }
+
+        //元素不会被搬移，args可以引用deque中的元素
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+                if (finish.cur != finish.last - 1)  //最后一个缓冲区还有至少两个空位
+                {
+                        construct(finish.cur, std::forward<Args>(args)...);
+                        ++finish.cur;
+                }
+                else
+                        emplace_back_aux(std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        void emplace_front(Args&&... args)
+        {
+                if (start.cur != start.first)  //第一个缓冲区还有空位
+                {
+                        construct(start.cur - 1, std::forward<Args>(args)...);
+                        --start.cur;
+                }
+                else
+                        emplace_front_aux(std::forward<Args>(args)...);
+        }
+
+        void pop_back()
+        {
+                if (finish.cur != finish.first)
+                {
+                        --finish.cur;
+                        SimSTL::destroy(finish.cur);
+                }
+                else
+                        pop_back_aux();
+        }
+
+        void pop_front()
+        {
+                if (start.cur != start.last - 1)
+                {
+                        SimSTL::destroy(start.cur);
+                        ++start.cur;
+                }
+                else
+                        pop_front_aux();
+        }
+
+        //在position之前以args构造元素，移动离position较近的一端
+        template <typename... Args>
+        iterator emplace(iterator position, Args&&... args);
+
+        iterator insert(iterator position, const T& x) { return emplace(position, x); }
+        iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+        void insert(iterator position, size_type n, const T& x);
+
+        template <typename InputIterator>
+        void insert(iterator position, InputIterator first, InputIterator last)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                insert_dispatch(position, first, last, integral());
+        }
+
+        iterator erase(iterator position);
+        iterator erase(iterator first, iterator last);
+
+        void resize(size_type new_size, const T& val)
+        {
+                const size_type len = size();
+                if (new_size < len)
+                        erase(start + difference_type(new_size), finish);
+                else
+                        insert(finish, new_size - len, val);
+        }
+
+        void resize(size_type new_size) { resize(new_size, T()); }
+
+        //释放除第一个缓冲区以外的所有缓冲区
+        void clear();
+};
+
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::create_map_and_nodes(size_type num_elements)
+{
+        const size_type num_nodes = num_elements / buffer_size() + 1;
+        ctrl.map_size = SimSTL::max(size_type(initial_map_size), num_nodes + 2);
+        ctrl.map = map_allocator::allocate(this->get_alloc(), ctrl.map_size);
+
+        //缓冲区放在map中间，两端留出相同的余量
+        map_pointer nstart = ctrl.map + (ctrl.map_size - num_nodes) / 2;
+        map_pointer nfinish = nstart + num_nodes;
+        ctrl.base = -(nstart - ctrl.map);  //nstart处的缓冲区编号为0
+        map_pointer cur = nstart;
+        try {
+                for (; cur < nfinish; ++cur)
+                        *cur = allocate_node();
+        }
+        catch(...) {
+                for (map_pointer n = nstart; n < cur; ++n)
+                        deallocate_node(*n);
+                map_allocator::deallocate(this->get_alloc(), ctrl.map, ctrl.map_size);
+                throw;
+        }
+
+        start.ctrl = finish.ctrl = &ctrl;
+        start.set_node(0);
+        finish.set_node(difference_type(num_nodes) - 1);
+        start.cur = start.first;
+        finish.cur = finish.first + num_elements % buffer_size();
+}
+
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::destroy_map_and_nodes()
+{
+        for (difference_type n = start.node; n <= finish.node; ++n)
+                deallocate_node(*ctrl.slot(n));
+        map_allocator::deallocate(this->get_alloc(), ctrl.map, ctrl.map_size);
+}
+
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::fill_initialize(size_type n, const T& value)
+{
+        create_map_and_nodes(n);
+        try {
+                SimSTL::uninitialized_fill(start, finish, value);
+        }
+        catch(...) {
+                destroy_map_and_nodes();
+                throw;
+        }
+}
+
+template <typename T, typename Alloc>
+template <typename InputIterator>
+void
+deque<T, Alloc>::initialize_dispatch(InputIterator first, InputIterator last, __false_type)
+{
+        create_map_and_nodes(0);
+        try {
+                for (; first != last; ++first)
+                        emplace_back(*first);
+        }
+        catch(...) {
+                clear();
+                destroy_map_and_nodes();
+                throw;
+        }
+}
+
+//空间足够时在map内部移动缓冲区指针使两端余量相同，否则配置更大的map。
+//缓冲区本身不动，只调整base使每个缓冲区的编号保持不变
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::reallocate_map(size_type nodes_to_add, bool add_at_front)
+{
+        map_pointer old_nstart = ctrl.slot(start.node);
+        map_pointer old_nfinish = ctrl.slot(finish.node);
+        const size_type old_num_nodes = old_nfinish - old_nstart + 1;
+        const size_type new_num_nodes = old_num_nodes + nodes_to_add;
+
+        map_pointer new_nstart;
+        if (ctrl.map_size > 2 * new_num_nodes)
+        {
+                new_nstart = ctrl.map + (ctrl.map_size - new_num_nodes) / 2
+                             + (add_at_front ? nodes_to_add : 0);
+                if (new_nstart < old_nstart)
+                        SimSTL::copy(old_nstart, old_nfinish + 1, new_nstart);
+                else
+                        SimSTL::copy_backward(old_nstart, old_nfinish + 1, new_nstart + old_num_nodes);
+        }
+        else
+        {
+                size_type new_map_size = ctrl.map_size + SimSTL::max(ctrl.map_size, nodes_to_add) + 2;
+                map_pointer new_map = map_allocator::allocate(this->get_alloc(), new_map_size);
+                new_nstart = new_map + (new_map_size - new_num_nodes) / 2
+                             + (add_at_front ? nodes_to_add : 0);
+                SimSTL::copy(old_nstart, old_nfinish + 1, new_nstart);
+                map_allocator::deallocate(this->get_alloc(), ctrl.map, ctrl.map_size);
+                ctrl.map = new_map;
+                ctrl.map_size = new_map_size;
+        }
+        ctrl.base = start.node - (new_nstart - ctrl.map);
+}
+
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::free_nodes(difference_type first_node, difference_type last_node)
+{
+        for (difference_type n = first_node; n < last_node; ++n)
+                deallocate_node(*ctrl.slot(n));
+}
+
+template <typename T, typename Alloc>
+typename deque<T, Alloc>::iterator
+deque<T, Alloc>::reserve_elements_at_front(size_type n)
+{
+        const size_type vacancies = start.cur - start.first;
+        if (n > vacancies)
+        {
+                const size_type new_nodes = (n - vacancies + buffer_size() - 1) / buffer_size();
+                reserve_map_at_front(new_nodes);
+                size_type i;
+                try {
+                        for (i = 1; i <= new_nodes; ++i)
+                                *ctrl.slot(start.node - difference_type(i)) = allocate_node();
+                }
+                catch(...) {
+                        free_nodes(start.node - difference_type(i) + 1, start.node);
+                        throw;
+                }
+        }
+        return start - difference_type(n);
+}
+
+template <typename T, typename Alloc>
+typename deque<T, Alloc>::iterator
+deque<T, Alloc>::reserve_elements_at_back(size_type n)
+{
+        const size_type vacancies = (finish.last - finish.cur) - 1;
+        if (n > vacancies)
+        {
+                const size_type new_nodes = (n - vacancies + buffer_size() - 1) / buffer_size();
+                reserve_map_at_back(new_nodes);
+                size_type i;
+                try {
+                        for (i = 1; i <= new_nodes; ++i)
+                                *ctrl.slot(finish.node + difference_type(i)) = allocate_node();
+                }
+                catch(...) {
+                        free_nodes(finish.node + 1, finish.node + difference_type(i));
+                        throw;
+                }
+        }
+        return finish + difference_type(n);
+}
+
+//最后一个缓冲区只剩一个空位时，先配置新缓冲区，再在这个空位构造元素
+template <typename T, typename Alloc>
+template <typename... Args>
+void
+deque<T, Alloc>::emplace_back_aux(Args&&... args)
+{
+        reserve_map_at_back();
+        *ctrl.slot(finish.node + 1) = allocate_node();
+        try {
+                construct(finish.cur, std::forward<Args>(args)...);
+        }
+        catch(...) {
+                deallocate_node(*ctrl.slot(finish.node + 1));
+                throw;
+        }
+        finish.set_node(finish.node + 1);
+        finish.cur = finish.first;
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+void
+deque<T, Alloc>::emplace_front_aux(Args&&... args)
+{
+        reserve_map_at_front();
+        pointer buf = allocate_node();
+        *ctrl.slot(start.node - 1) = buf;
+        try {
+                construct(buf + buffer_size() - 1, std::forward<Args>(args)...);
+        }
+        catch(...) {
+                deallocate_node(buf);
+                throw;
+        }
+        start.set_node(start.node - 1);
+        start.cur = start.last - 1;
+}
+
+//最后一个缓冲区为空，释放它并析构前一个缓冲区的最后一个元素
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::pop_back_aux()
+{
+        deallocate_node(finish.first);
+        finish.set_node(finish.node - 1);
+        finish.cur = finish.last - 1;
+        SimSTL::destroy(finish.cur);
+}
+
+//第一个缓冲区只有一个元素，析构后释放这个缓冲区
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::pop_front_aux()
+{
+        SimSTL::destroy(start.cur);
+        deallocate_node(start.first);
+        start.set_node(start.node + 1);
+        start.cur = start.first;
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+typename deque<T, Alloc>::iterator
+deque<T, Alloc>::emplace(iterator position, Args&&... args)
+{
+        if (position.cur == start.cur)
+        {
+                emplace_front(std::forward<Args>(args)...);
+                return start;
+        }
+        if (position.cur == finish.cur)
+        {
+                emplace_back(std::forward<Args>(args)...);
+                return finish - 1;
+        }
+
+        T x_copy(std::forward<Args>(args)...);  //args可能引用将被移动的元素
+        const difference_type index = position - start;
+        if (size_type(index) < size() / 2)  //插入点之前的元素较少，向前端移动
+        {
+                emplace_front(std::move(front()));
+                iterator front1 = start;
+                ++front1;
+                iterator front2 = front1;
+                ++front2;
+                position = start + index;
+                iterator pos1 = position;
+                ++pos1;
+                SimSTL::move(front2, pos1, front1);
+        }
+        else  //插入点之后的元素较少，向尾端移动
+        {
+                emplace_back(std::move(back()));
+                iterator back1 = finish;
+                --back1;
+                iterator back2 = back1;
+                --back2;
+                position = start + index;
+                SimSTL::move_backward(position, back2, back1);
+        }
+        *position = std::move(x_copy);
+        return position;
+}
+
+//先在离插入点较近的一端配置空间，再把这一端的元素移开
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::insert(iterator position, size_type n, const T& x)
+{
+        if (n == 0)
+                return ;
+        T x_copy = x;
+        const difference_type index = position - start;
+        const size_type len = size();
+        if (size_type(index) < len / 2)
+        {
+                iterator new_start = reserve_elements_at_front(n);
+                iterator old_start = start;
+                try {
+                        SimSTL::uninitialized_fill(new_start, old_start, x_copy);
+                }
+                catch(...) {
+                        free_nodes(new_start.node, start.node);
+                        throw;
+                }
+                start = new_start;
+                //[old_start, old_start + index)前移n个位置，空出的n个位置填入x
+                iterator mid = SimSTL::move(old_start, old_start + index, new_start);
+                SimSTL::fill(mid, mid + difference_type(n), x_copy);
+        }
+        else
+        {
+                iterator new_finish = reserve_elements_at_back(n);
+                iterator old_finish = finish;
+                try {
+                        SimSTL::uninitialized_fill(old_finish, new_finish, x_copy);
+                }
+                catch(...) {
+                        free_nodes(finish.node + 1, new_finish.node + 1);
+                        throw;
+                }
+                finish = new_finish;
+                const difference_type elems_after = difference_type(len) - index;
+                iterator pos = old_finish - elems_after;
+                SimSTL::move_backward(pos, old_finish, new_finish);
+                SimSTL::fill(pos, pos + difference_type(n), x_copy);
+        }
+}
+
+//移动离position较近的一端的元素
+template <typename T, typename Alloc>
+typename deque<T, Alloc>::iterator
+deque<T, Alloc>::erase(iterator position)
+{
+        iterator next = position;
+        ++next;
+        const difference_type index = position - start;
+        if (size_type(index) < size() / 2)
+        {
+                SimSTL::move_backward(start, position, next);
+                pop_front();
+        }
+        else
+        {
+                SimSTL::move(next, finish, position);
+                pop_back();
+        }
+        return start + index;
+}
+
+template <typename T, typename Alloc>
+typename deque<T, Alloc>::iterator
+deque<T, Alloc>::erase(iterator first, iterator last)
+{
+        if (first == last)
+                return first;
+        if (first == start && last == finish)
+        {
+                clear();
+                return finish;
+        }
+
+        const difference_type n = last - first;
+        const difference_type elems_before = first - start;
+        if (size_type(elems_before) < (size() - n) / 2)  //前端的元素较少
+        {
+                SimSTL::move_backward(start, first, last);
+                iterator new_start = start + n;
+                SimSTL::destroy(start, new_start);
+                free_nodes(start.node, new_start.node);
+                start = new_start;
+        }
+        else
+        {
+                SimSTL::move(last, finish, first);
+                iterator new_finish = finish - n;
+                SimSTL::destroy(new_finish, finish);
+                free_nodes(new_finish.node + 1, finish.node + 1);
+                finish = new_finish;
+        }
+        return start + elems_before;
+}
+
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::clear()
+{
+        for (difference_type n = start.node + 1; n < finish.node; ++n)
+        {
+                pointer buf = *ctrl.slot(n);
+                SimSTL::destroy(buf, buf + buffer_size());
+                deallocate_node(buf);
+        }
+
+        if (start.node != finish.node)
+        {
+                SimSTL::destroy(start.cur, start.last);
+                SimSTL::destroy(finish.first, finish.cur);
+                deallocate_node(finish.first);
+        }
+        else
+                SimSTL::destroy(start.cur, finish.cur);
+        finish = start;
+}
+
+//交换map后把start和finish重新指向各自的中控器
+template <typename T, typename Alloc>
+void
+deque<T, Alloc>::swap_data(deque& x)
+{
+        SimSTL::swap(start, x.start);
+        SimSTL::swap(finish, x.finish);
+        SimSTL::swap(ctrl, x.ctrl);
+        start.ctrl = finish.ctrl = &ctrl;
+        x.start.ctrl = x.finish.ctrl = &x.ctrl;
+}
+
+template <typename T, typename Alloc>
+inline void
+swap(deque<T, Alloc>& x, deque<T, Alloc>& y)
+{
+        x.swap(y);
+}
+
+
+}
+
+#endif
@@ -0,0 +1,409 @@
+#ifndef _MINISTL_INTRUSIVE_LIST_H_
+#define _MINISTL_INTRUSIVE_LIST_H_
+
+#include "simlist.h"  //for __list_node_base, __list_transfer
+#include "simiterator.h"
+#include "simalgobase.h"
+#include <cstddef>
+
+namespace SimSTL {
+
+
+//钩子未指定标记时使用的标记。同一对象要链入多个intrusive_list时，
+//每个基类钩子使用不同的标记
+struct default_list_tag;
+
+//普通钩子：嵌入对象中，对象链入intrusive_list时不配置节点。
+//未链入时prev、next为NULL；对象析构前必须先从intrusive_list中移除
+template <typename Tag = default_list_tag>
+struct list_hook : public __list_node_base
+{
+        enum { auto_unlink = 0 };
+
+        list_hook() { prev = next = 0; }
+        list_hook(const list_hook&) { prev = next = 0; }  //复制对象不复制链接
+        list_hook& operator=(const list_hook&) { return *this; }
+
+        bool is_linked() const { return next != 0; }
+};
+
+//自动脱链钩子：析构时如果仍在某个intrusive_list中就自行移除。
+//移除时list不知情，所以使用这种钩子的intrusive_list的size()需要遍历
+template <typename Tag = default_list_tag>
+struct auto_unlink_list_hook : public list_hook<Tag>
+{
+        enum { auto_unlink = 1 };
+
+        ~auto_unlink_list_hook() { unlink(); }
+
+        void unlink()
+        {
+                if (!this->is_linked())
+                        return ;
+                ((__list_node_base *)this->prev)->next = this->next;
+                ((__list_node_base *)this->next)->prev = this->prev;
+                this->prev = this->next = 0;
+        }
+};
+
+//钩子是T的基类
+template <typename T, typename Hook = list_hook<> >
+struct list_base_hook_traits
+{
+        typedef T       value_type;
+        typedef Hook    hook_type;
+
+        static __list_node_base *to_node(T& x) { return static_cast<Hook *>(&x); }
+        static T *to_value(__list_node_base *n) { return static_cast<T *>(static_cast<Hook *>(n)); }
+};
+
+//钩子是T的数据成员Member。
+//成员指针不能用于offsetof，Member在T中的偏移量在程序启动时由一块未构造的T大小的存储算出，
+//之后to_value只是一次指针调整。静态初始化期间（main之前）不要用它链接或访问元素
+template <typename T, typename Hook, Hook T::*Member>
+struct list_member_hook_traits
+{
+        typedef T       value_type;
+        typedef Hook    hook_type;
+
+        static __list_node_base *to_node(T& x) { return &(x.*Member); }
+        static T *to_value(__list_node_base *n)
+        {
+                return (T *)((char *)static_cast<Hook *>(n) - offset);
+        }
+
+private:
+        static const ptrdiff_t offset;
+
+        //只计算成员的地址，不读写存储中的内容
+        static ptrdiff_t compute_offset()
+        {
+                alignas(T) unsigned char storage[sizeof(T)];
+                const T *p = reinterpret_cast<const T *>(storage);
+                return (const char *)&(p->*Member) - (const char *)p;
+        }
+};
+
+template <typename T, typename Hook, Hook T::*Member>
+const ptrdiff_t list_member_hook_traits<T, Hook, Member>::offset
+    = list_member_hook_traits<T, Hook, Member>::compute_offset();
+
+// intrusive_list迭代器，与__list_iterator相同，只是由钩子换算出元素
+template <typename Traits, typename Ref, typename Ptr>
+struct __intrusive_list_iterator
+{
+        typedef typename Traits::value_type                             T;
+        typedef __intrusive_list_iterator<Traits, T&, T*>               iterator;
+        typedef __intrusive_list_iterator<Traits, const T&, const T*>   const_iterator;
+        typedef __intrusive_list_iterator<Traits, Ref, Ptr>             self;
+
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef T               value_type;
+        typedef ptrdiff_t       difference_type;
+        typedef Ptr             pointer;
+        typedef Ref             reference;
+        typedef size_t          size_type;
+        typedef __list_node_base* base_ptr;
+
+        base_ptr node;  // 指向元素中的钩子，end()指向intrusive_list中的空白节点
+
+        // constructor
+        __intrusive_list_iterator(base_ptr x) : node(x) {}
+        __intrusive_list_iterator() {}
+        __intrusive_list_iterator(const __intrusive_list_iterator&) = default;
+        __intrusive_list_iterator& operator=(const __intrusive_list_iterator&) = default;
+        //iterator转换为const_iterator，只接受元素指针为T*的迭代器
+        template <typename R>
+        __intrusive_list_iterator(const __intrusive_list_iterator<Traits, R, T*>& x) : node(x.node) {}
+
+        bool operator==(const self& x) const { return node == x.node; }
+        bool operator!=(const self& x) const { return node != x.node; }
+        reference operator*() const { return *Traits::to_value(node); }
+        pointer operator->() const { return &(operator*()); }
+        self& operator++() { node = (base_ptr)(*node).next; return *this;}
+        self operator++(int)
+        {
+                self tmp = *this;
+                ++*this;
+                return tmp;
+        }
+        self& operator--() { node = (base_ptr)(*node).prev; return *this;}
+        self operator--(int)
+        {
+                self tmp = *this;
+                --*this;
+                return tmp;
+        }
+};
+
+// intrusive_list
+//元素自带链接（钩子），list只把元素的钩子串起来，不配置、不复制也不析构元素。
+//一个元素同一时刻只能通过同一个钩子链入一个list；erase只是把元素移出list。
+//Traits为list_base_hook_traits或list_member_hook_traits
+template <typename T, typename Traits = list_base_hook_traits<T> >
+class intrusive_list
+{
+public:
+        // 基础类型
+        typedef T                       value_type;
+        typedef ptrdiff_t               difference_type;
+        typedef value_type*             pointer;
+        typedef const value_type*       const_pointer;
+        typedef value_type&             reference;
+        typedef const value_type&       const_reference;
+        typedef size_t                  size_type;
+        typedef Traits                  value_traits;
+
+        //自动脱链的元素可能在list不知情时离开，这时不缓存元素个数
+        enum { constant_time_size = !Traits::hook_type::auto_unlink };
+
+        // 迭代器
+        typedef __intrusive_list_iterator<Traits, T&, T*>               iterator;
+        typedef __intrusive_list_iterator<Traits, const T&, const T*>   const_iterator;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+
+private:
+        typedef __list_node_base* base_ptr;
+
+        __list_node_base        node;
+        size_type               length;  //constant_time_size为0时不使用
+
+        base_ptr head() const { return const_cast<base_ptr>(&node); }
+
+        static base_ptr to_node(T& x) { return Traits::to_node(x); }
+        static base_ptr to_node(const T& x) { return Traits::to_node(const_cast<T&>(x)); }
+
+        //将p链入position之前
+        void link_node(base_ptr position, base_ptr p)
+        {
+                p->next = position;
+                p->prev = position->prev;
+                ((base_ptr)position->prev)->next = p;
+                position->prev = p;
+                ++length;
+        }
+
+        //移出p并把钩子恢复为未链入状态
+        void unlink_node(base_ptr p)
+        {
+                ((base_ptr)p->prev)->next = p->next;
+                ((base_ptr)p->next)->prev = p->prev;
+                p->prev = p->next = 0;
+                --length;
+        }
+
+        void empty_initialize()
+        {
+                node.next = &node;
+                node.prev = &node;
+                length = 0;
+        }
+
+        void swap_nodes(intrusive_list& x);
+
+        intrusive_list(const intrusive_list&);
+        intrusive_list& operator=(const intrusive_list&);
+
+public:
+        intrusive_list() { empty_initialize(); }
+
+        //接管x中的元素，x变为空
+        intrusive_list(intrusive_list&& x)
+        {
+                empty_initialize();
+                swap_nodes(x);
+        }
+
+        //只移出元素，元素本身由使用者管理
+        ~intrusive_list() { clear(); }
+
+        intrusive_list& operator=(intrusive_list&& x)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        swap_nodes(x);
+                }
+                return *this;
+        }
+
+        void swap(intrusive_list& x) { swap_nodes(x); }
+
+public:
+        iterator begin() { return (base_ptr)node.next; }
+        iterator end() { return head(); }
+        const_iterator begin() const { return (base_ptr)node.next; }
+        const_iterator end() const { return head(); }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        bool empty() const { return node.next == &node; }
+        size_type size() const
+        {
+                return constant_time_size ? length : (size_type)SimSTL::distance(begin(), end());
+        }
+
+        reference front() { return *begin(); }
+        const_reference front() const { return *begin(); }
+        reference back() { return *(--end()); }
+        const_reference back() const { return *(--end()); }
+
+        //x所在位置的迭代器，x必须已链入某个使用同一钩子的list
+        static iterator iterator_to(T& x) { return to_node(x); }
+        static const_iterator iterator_to(const T& x) { return to_node(x); }
+
+public:
+        //x不能已链入其他list
+        iterator insert(iterator position, T& x)
+        {
+                base_ptr p = to_node(x);
+                link_node(position.node, p);
+                return p;
+        }
+
+        void push_back(T& x) { insert(end(), x); }
+        void push_front(T& x) { insert(begin(), x); }
+        void pop_front() { erase(begin()); }
+        void pop_back() { iterator tmp = end(); erase(--tmp); }
+
+        iterator erase(iterator position)
+        {
+                base_ptr next = (base_ptr)position.node->next;
+                unlink_node(position.node);
+                return next;
+        }
+
+        iterator erase(iterator first, iterator last)
+        {
+                while (first != last)
+                        erase(first++);
+                return last;
+        }
+
+        //O(1)地移出x，x必须在这个list中
+        void erase(T& x) { unlink_node(to_node(x)); }
+
+        void clear();
+
+        void splice(iterator position, intrusive_list& x);
+        void splice(iterator position, intrusive_list& x, iterator i);
+        void splice(iterator position, intrusive_list& x, iterator first, iterator last);
+        //n必须等于distance(first, last)，不再遍历区间
+        void splice(iterator position, intrusive_list& x, iterator first, iterator last, size_type n);
+
+        void reverse();
+};
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::clear()
+{
+        base_ptr cur = (base_ptr)node.next;
+        while (cur != &node)
+        {
+                base_ptr next = (base_ptr)cur->next;
+                cur->prev = cur->next = 0;
+                cur = next;
+        }
+        empty_initialize();
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::splice(iterator position, intrusive_list& x)
+{
+        if (!x.empty())
+        {
+                __list_transfer(position.node, x.begin().node, x.end().node);
+                length += x.length;
+                x.length = 0;
+        }
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::splice(iterator position, intrusive_list& x, iterator i)
+{
+        iterator j = i;
+        ++j;
+        if (position == i || position == j)
+                return ;
+        __list_transfer(position.node, i.node, j.node);
+        ++length;
+        --x.length;
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::splice(iterator position, intrusive_list& x, iterator first, iterator last)
+{
+        if (first == last)
+                return ;
+        const size_type n = &x == this || !constant_time_size
+                            ? 0 : (size_type)SimSTL::distance(first, last);
+        splice(position, x, first, last, n);
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::splice(iterator position, intrusive_list& x,
+                                  iterator first, iterator last, size_type n)
+{
+        if (first == last)
+                return ;
+        __list_transfer(position.node, first.node, last.node);
+        if (&x != this)
+        {
+                length += n;
+                x.length -= n;
+        }
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::reverse()
+{
+        if (node.next == &node || ((base_ptr)node.next)->next == &node)
+                return ;
+        iterator first = begin();
+        ++first;
+        while (first != end())
+        {
+                iterator old = first;
+                ++first;
+                __list_transfer((base_ptr)node.next, old.node, first.node);
+        }
+}
+
+template <typename T, typename Traits>
+void
+intrusive_list<T, Traits>::swap_nodes(intrusive_list& x)
+{
+        const bool this_empty = empty();
+        const bool x_empty = x.empty();
+        SimSTL::swap(node.next, x.node.next);
+        SimSTL::swap(node.prev, x.node.prev);
+        SimSTL::swap(length, x.length);
+        if (x_empty)
+                node.next = node.prev = &node;
+        else
+                ((base_ptr)node.next)->prev = ((base_ptr)node.prev)->next = &node;
+        if (this_empty)
+                x.node.next = x.node.prev = &x.node;
+        else
+                ((base_ptr)x.node.next)->prev = ((base_ptr)x.node.prev)->next = &x.node;
+}
+
+template <typename T, typename Traits>
+inline void
+swap(intrusive_list<T, Traits>& x, intrusive_list<T, Traits>& y)
+{
+        x.swap(y);
+}
+
+
+}
+
+#endif
@@ -26,6 +26,8 @@ public:
         reverse_iterator() {}
         explicit reverse_iterator(iterator_type x):current(x) {}
 
+        iterator_type base() const { return current; }
+
 public:
         reference operator*() const
         {
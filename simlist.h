@@ -4,20 +4,205 @@
 #include "simiterator.h"
 #include "simalloc.h"
 #include "simalgobase.h"
+#include "simconstruct.h"
+#include <cstddef>
+#include <cstdlib> //for malloc
+#include <cstring> //for memcpy
+
+//定义__SIMSTL_THREADS时才提供parallel_sort，单线程的程序不需要<thread>和线程库
+#ifdef __SIMSTL_THREADS
+#include <exception> //for std::exception_ptr
+#include <thread>
+
+//parallel_sort中每个线程至少分到的元素个数
+#ifndef __SIMSTL_LIST_PARALLEL_SORT_GRAIN
+#define __SIMSTL_LIST_PARALLEL_SORT_GRAIN 65536
+#endif
+#endif
 
 namespace SimSTL {
 
 
-// list节点
-template <typename T>
-struct __list_node
+// list节点的链接部分，list对象内的空白节点只有这一部分
+struct __list_node_base
 {
         typedef void* void_pointer;
         void_pointer prev;
         void_pointer next;
+};
+
+//把[first, last)的节点搬到position之前，三者可以属于不同的链表。
+//list与intrusive_list的splice、merge、reverse都由它完成
+inline void __list_transfer(__list_node_base *position,
+                            __list_node_base *first, __list_node_base *last)
+{
+        typedef __list_node_base* base_ptr;
+        (*(base_ptr((*last).prev))).next = position;
+        (*(base_ptr((*first).prev))).next = last;
+        (*(base_ptr((*position).prev))).next = first;
+        base_ptr tmp = base_ptr((*position).prev);
+        (*position).prev = (*last).prev;
+        (*last).prev = (*first).prev;
+        (*first).prev = tmp;
+}
+
+// list节点
+template <typename T>
+struct __list_node : public __list_node_base
+{
         T data;
 };
 
+//sort()的默认比较方式
+struct __list_less
+{
+        template <typename T>
+        bool operator()(const T& a, const T& b) const { return a < b; }
+};
+
+//以下是gather_sort收集节点指针后使用的排序函数，Link为__list_node<T>*，按节点中的data比较
+
+//对[first, last)做插入排序，稳定
+template <typename Link, typename Compare>
+void
+__list_ptr_insertion_sort(Link *first, Link *last, Compare& comp)
+{
+        for (Link *i = first + 1; i < last; ++i)
+        {
+                Link value = *i;
+                Link *j = i;
+                for (; j != first && comp(value->data, (*(j - 1))->data); --j)
+                        *j = *(j - 1);
+                *j = value;
+        }
+}
+
+//合并两段有序的指针，相等时[first1, last1)中的在前
+template <typename Link, typename Compare>
+Link *
+__list_ptr_merge(Link *first1, Link *last1, Link *first2, Link *last2, Link *result, Compare& comp)
+{
+        while (first1 != last1 && first2 != last2)
+        {
+                if (comp((*first2)->data, (*first1)->data))
+                        *result++ = *first2++;
+                else
+                        *result++ = *first1++;
+        }
+        memcpy(result, first1, (last1 - first1) * sizeof(Link));
+        result += last1 - first1;
+        memcpy(result, first2, (last2 - first2) * sizeof(Link));
+        return result + (last2 - first2);
+}
+
+//自底向上的稳定归并排序：先把每32个指针插入排序，再在first与tmp之间来回合并。
+//返回结果所在的缓冲区（first或tmp）
+template <typename Link, typename Compare>
+Link *
+__list_ptr_merge_sort(Link *first, Link *tmp, size_t n, Compare& comp)
+{
+        const size_t run = 32;
+        for (size_t i = 0; i < n; i += run)
+                __list_ptr_insertion_sort(first + i, first + (i + run < n ? i + run : n), comp);
+
+        Link *from = first;
+        Link *to = tmp;
+        for (size_t width = run; width < n; width *= 2)
+        {
+                for (size_t lo = 0; lo < n; lo += 2 * width)
+                {
+                        size_t mid = lo + width < n ? lo + width : n;
+                        size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+                        __list_ptr_merge(from + lo, from + mid, from + mid, from + hi, to + lo, comp);
+                }
+                SimSTL::swap(from, to);
+        }
+        return from;
+}
+
+#ifdef __SIMSTL_THREADS
+//task(0)在当前线程执行，task(1)到task(count - 1)各用一个线程；线程创建失败时在当前线程执行。
+//所有任务结束后重新抛出第一个异常
+template <typename Task>
+void
+__list_run_parallel(size_t count, Task& task)
+{
+        std::thread workers[64];
+        std::exception_ptr errors[64];
+        for (size_t i = count; i-- > 0; )
+        {
+                auto run = [&task, &errors, i]() {
+                        try {
+                                task(i);
+                        }
+                        catch(...) {
+                                errors[i] = std::current_exception();
+                        }
+                };
+                if (i == 0)
+                {
+                        run();
+                        break;
+                }
+                try {
+                        workers[i] = std::thread(run);
+                }
+                catch(...) {
+                        run();
+                }
+        }
+        for (size_t i = 1; i < count; ++i)
+        {
+                if (workers[i].joinable())
+                        workers[i].join();
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+                if (errors[i])
+                        std::rethrow_exception(errors[i]);
+        }
+}
+
+//把n个指针分成chunks段（不超过64）并行排序，再两两并行合并。
+//comp会在多个线程中同时调用。返回结果所在的缓冲区
+template <typename Link, typename Compare>
+Link *
+__list_ptr_parallel_sort(Link *buf, Link *tmp, size_t n, Compare& comp, size_t chunks)
+{
+        size_t bounds[65];
+        for (size_t i = 0; i <= chunks; ++i)
+                bounds[i] = n / chunks * i + (i < n % chunks ? i : n % chunks);
+
+        //每段排好后都放回buf
+        auto sort_chunk = [&](size_t i) {
+                const size_t lo = bounds[i];
+                Link *sorted = __list_ptr_merge_sort(buf + lo, tmp + lo, bounds[i + 1] - lo, comp);
+                if (sorted != buf + lo)
+                        memcpy(buf + lo, sorted, (bounds[i + 1] - lo) * sizeof(Link));
+        };
+        __list_run_parallel(chunks, sort_chunk);
+
+        Link *from = buf;
+        Link *to = tmp;
+        while (chunks > 1)
+        {
+                auto merge_pair = [&](size_t i) {
+                        const size_t lo = bounds[2 * i];
+                        const size_t mid = bounds[2 * i + 1];
+                        const size_t hi = 2 * i + 2 <= chunks ? bounds[2 * i + 2] : mid;
+                        __list_ptr_merge(from + lo, from + mid, from + mid, from + hi, to + lo, comp);
+                };
+                const size_t pairs = (chunks + 1) / 2;
+                __list_run_parallel(pairs, merge_pair);
+                for (size_t i = 0; i <= pairs; ++i)
+                        bounds[i] = bounds[2 * i < chunks ? 2 * i : chunks];
+                chunks = pairs;
+                SimSTL::swap(from, to);
+        }
+        return from;
+}
+#endif
+
 // list迭代器
 template <typename T, typename Ref, typename Ptr>
 struct __list_iterator
@@ -26,33 +211,38 @@ struct __list_iterator
         typedef __list_iterator<T, const T&, const T*>  const_iterator;
         typedef __list_iterator<T, Ref, Ptr>            self;
 
-        typedef bidirectional_iterator_tag iterator_tag;
+        typedef bidirectional_iterator_tag iterator_category;
         typedef T               value_type;
         typedef ptrdiff_t       difference_type;
         typedef Ptr             pointer;
         typedef Ref             reference;
         typedef size_t          size_type;
         typedef __list_node<T>* link_type;
+        typedef __list_node_base* base_ptr;
 
-        link_type node;  // point to __list_node
+        base_ptr node;  // 指向__list_node，end()指向list中的空白节点
 
         // constructor
-        __list_iterator(link_type x) : node(x) {}
+        __list_iterator(base_ptr x) : node(x) {}
         __list_iterator() {}
-        __list_iterator(const iterator& x) : node(x.node) {}
+        __list_iterator(const __list_iterator&) = default;
+        __list_iterator& operator=(const __list_iterator&) = default;
+        //iterator转换为const_iterator，只接受元素指针为T*的迭代器
+        template <typename R>
+        __list_iterator(const __list_iterator<T, R, T*>& x) : node(x.node) {}
 
         bool operator==(const self& x) const { return node == x.node; }
         bool operator!=(const self& x) const { return node != x.node; }
-        reference operator*() const { return (*node).data; }
+        reference operator*() const { return ((link_type)node)->data; }
         pointer operator->() const { return &(operator*());}
-        self& operator++() { node = (link_type)(*node).next; return *this;}
+        self& operator++() { node = (base_ptr)(*node).next; return *this;}
         self operator++(int)
         {
                 self tmp = *this;
                 ++*this;
                 return tmp;
         }
-        self& operator--() { node = (link_type)(*node).prev; return *this;}
+        self& operator--() { node = (base_ptr)(*node).prev; return *this;}
         self operator--(int)
         {
                 self tmp = *this;
@@ -62,8 +252,10 @@ struct __list_iterator
 };
 
 // list
-template <typename T>
-class list
+//Alloc可以是有状态的配置器对象，保存在list中，随list复制和交换。
+//splice与merge在两个list之间搬移节点，要求两者的配置器可以互相释放对方的节点
+template <typename T, typename Alloc = alloc>
+class list : private __alloc_holder<Alloc>
 {
 public:
         // 基础类型
@@ -77,34 +269,43 @@ public:
 
         typedef __list_node<T>          list_node;
         typedef list_node*              link_type;
+        typedef __list_node_base*       base_ptr;
 
         // 空间配置器
-        typedef simple_alloc<list_node, alloc> list_node_allocator;
+        typedef simple_alloc<list_node, Alloc> list_node_allocator;
+        typedef Alloc allocator_type;
+
+        allocator_type get_allocator() const { return this->get_alloc(); }
 
 private:
-        //指向空白节点
-        link_type               node;
+        typedef __alloc_holder<Alloc> alloc_holder;
+
+        //空白节点直接放在list对象中，空list不配置任何节点
+        __list_node_base        node;
+        size_type               length;  //元素个数，由链入、移除节点的操作维护
+
+        base_ptr head() const { return const_cast<base_ptr>(&node); }
 
 public:
         // 迭代器
         typedef __list_iterator<T, T&, T*>              iterator;
         typedef __list_iterator<T, const T&, const T*>  const_iterator;
-        typedef reverse_iterator<iterator>              reverse_iterator;
-        typedef reverse_iterator<const_iterator>        const_reverse_iterator;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
 
 public:
         // 通过空白节点node完成
-        iterator begin() const { return (link_type)(*node).next; }
-        iterator end() const { return node;}
-        bool empty() const { return node->next == node; }
-        size_type size() const { return (size_type)distance(begin(), end); }
+        iterator begin() const { return (base_ptr)node.next; }
+        iterator end() const { return head(); }
+        bool empty() const { return node.next == &node; }
+        size_type size() const { return length; }
         reference front() const { return *begin(); }
         reference back() const { return *(--end());}
 
 private:
         // 内部操作
-        link_type get_node() { return list_node_allocator::allocate(1);}
-        void put_node(link_type p) { list_node_allocator::deallocate(p, 1); }
+        link_type get_node() { return list_node_allocator::allocate(this->get_alloc(), 1);}
+        void put_node(link_type p) { list_node_allocator::deallocate(this->get_alloc(), p, 1); }
 
         link_type create_node(const T& x)
         {
@@ -115,36 +316,105 @@ private:
 
         void destroy_node(link_type p)
         {
-                destroy(p, 1);
+                destroy(&p->data);
                 put_node(p);
         }
 
+        //将节点p链入position之前
+        void link_node(iterator position, link_type p)
+        {
+                p->next = position.node;
+                p->prev = position.node->prev;
+                ((base_ptr)position.node->prev)->next = p;
+                position.node->prev = p;
+                ++length;
+        }
+
+        //归还从chain开始尚未构造的n个节点
+        void put_chain(link_type chain, size_type n)
+        {
+                link_type last = chain;
+                for (size_type i = 1; i < n; ++i)
+                        last = list_node_allocator::chain_next(last);
+                list_node_allocator::deallocate_chain(this->get_alloc(), chain, last, n);
+        }
+
+        //在position之前插入[first, first + n)，n个节点一次从配置器取得
+        template <typename InputIterator>
+        void insert_chain(iterator position, InputIterator first, size_type n);
+
         void empty_initialize()
         {
-                node = get_node();
-                node->next = node;
-                node->prev = node;
+                node.next = &node;
+                node.prev = &node;
+                length = 0;
         }
 
+        //交换两个list的节点，空白节点留在原处，首尾节点改为指向新的空白节点
+        void swap_nodes(list& x);
+
         void transfer(iterator position, iterator first, iterator last);
 
+        //合并两条以NULL结尾、按next串起的有序节点链，结果放在a中，b置为NULL，
+        //相等时a中的节点在前。比较抛出异常时两条链的节点也都串在a中
+        template <typename Compare>
+        static void merge_runs(link_type& a, link_type& b, Compare& comp);
+
+        //把以NULL结尾的节点链接在tail之后，补全prev指针，tail移到链尾
+        static void append_chain(base_ptr& tail, link_type chain)
+        {
+                for (; chain != NULL; chain = (link_type)chain->next)
+                {
+                        chain->prev = tail;
+                        tail->next = chain;
+                        tail = chain;
+                }
+        }
+
+        //直接在节点链上归并，不需要额外空间
+        template <typename Compare>
+        void merge_sort_nodes(Compare& comp);
+
+        //把节点指针收集到缓冲区中排序后重新链接，threads大于1时并行排序。
+        //缓冲区直接向malloc申请，不经过list的配置器；申请失败时返回false，list保持不变
+        template <typename Compare>
+        bool gather_sort_aux(Compare& comp, size_t threads);
+
 public:
         iterator insert(iterator position, const T& x);
         iterator insert(iterator position);
-        iterator insert(iterator position, size_type n, const T& x);
-        iterator insert(iterator position, iterator first, iterator last);
+        void insert(iterator position, size_type n, const T& x);
+        void insert(iterator position, iterator first, iterator last);
+        void insert(iterator position, const_iterator first, const_iterator last);
         iterator erase(iterator position);
         iterator erase(iterator first, iterator last);
         void clear();
         void remove(const T& x);
         void unique();
-        void splice(iterator position, list<T>& x);
-        void splice(iterator position, list<T>& x, iterator i);
-        void splice(iterator position, list<T>& x, iterator first, iterator last);
-        void merge(list<T>& x);
+        void splice(iterator position, list& x);
+        void splice(iterator position, list& x, iterator i);
+        void splice(iterator position, list& x, iterator first, iterator last);
+        //n必须等于distance(first, last)，不再遍历区间
+        void splice(iterator position, list& x, iterator first, iterator last, size_type n);
+        void merge(list& x);
         void reverse();
-        void sort();
-        void swap(list<T>& x);
+        //稳定排序，只改动节点的链接，不复制、移动元素，也不配置内存。
+        //比较抛出异常时元素都还在list中，但顺序不确定
+        void sort() { sort(__list_less()); }
+        template <typename Compare>
+        void sort(Compare comp);
+        //与sort相同，但先把节点指针收集到临时缓冲区（2n个指针，来自malloc）中排序，
+        //元素很多时cache miss少得多。比较抛出异常时list保持不变；缓冲区申请失败时改用sort
+        void gather_sort() { gather_sort(__list_less()); }
+        template <typename Compare>
+        void gather_sort(Compare comp);
+#ifdef __SIMSTL_THREADS
+        //元素很多时用至多threads个线程排序（0表示硬件线程数），comp必须可以在多个线程中同时调用
+        void parallel_sort(unsigned threads = 0) { parallel_sort(__list_less(), threads); }
+        template <typename Compare>
+        void parallel_sort(Compare comp, unsigned threads);
+#endif
+        void swap(list& x);
 
         void push_back(const T& x) { insert(end(), x); }
         void push_front(const T& x) { insert(begin(), x); }
@@ -154,31 +424,54 @@ public:
 public:
         list() { empty_initialize();}
 
-        explicit list(size_type n)
+        explicit list(const allocator_type& a) : alloc_holder(a) { empty_initialize(); }
+
+        explicit list(size_type n, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
         {
                 empty_initialize();
                 insert(begin(), n, T());
         }
 
-        list(const list<T>& x)
+        list(const list& x) : alloc_holder(x.get_alloc())
         {
                 empty_initialize();
                 insert(begin(), x.begin(), x.end());
         }
 
-        list(iterator first, iterator last)
+        list(iterator first, iterator last, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
         {
                 empty_initialize();
                 insert(begin(), first, last);
         }
 
-        ~list() {}
-        list<T>& operator=(const list<T>& x);
+        //接管x的节点和配置器，x变为空
+        list(list&& x) : alloc_holder(x.get_alloc())
+        {
+                empty_initialize();
+                swap_nodes(x);
+        }
+
+        ~list() { clear(); }
+
+        list& operator=(const list& x);
+
+        list& operator=(list&& x)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        SimSTL::swap(this->get_alloc(), x.get_alloc());
+                        swap_nodes(x);
+                }
+                return *this;
+        }
 };
 
-template <typename T>
-list<T>&
-list<T>::operator=(const list<T>& x)
+template <typename T, typename Alloc>
+list<T, Alloc>&
+list<T, Alloc>::operator=(const list& x)
 {
         if (this == &x)
                 return *this;
@@ -195,92 +488,134 @@ list<T>::operator=(const list<T>& x)
         return *this;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::transfer(iterator position, iterator first, iterator last)
+list<T, Alloc>::transfer(iterator position, iterator first, iterator last)
 {
-        (*(link_type((*last.node).prev))).next = position.node;
-        (*(link_type((*first.node).prev))).next = last.node;
-        (*(link_type((*position.node).prev))).next = last.node;
-        link_type tmp = link_type((*position.node).prev);
-        (*last.node).prev = (*first.node).prev;
-        (*first.node).prev = tmp;
+        __list_transfer(position.node, first.node, last.node);
 }
 
-template <typename T>
-void
-list<T>::insert(iterator position, const T& x)//posiiton之前插入
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::insert(iterator position, const T& x)//posiiton之前插入
 {
         link_type tmp = create_node(x);
-        tmp->next = position.node;
-        tmp->prev = position.node->prev;
-        (link_type(position.node->prev))->next = tmp;
-        position.node->prev = tmp;
+        link_node(position, tmp);
         return tmp;
 }
 
-template <typename T>
-void
-list<T>::insert(iterator position)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::insert(iterator position)
 {
-        insert(position, T());
+        return insert(position, T());
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::insert(iterator position, size_type n, const T& x)
+list<T, Alloc>::insert(iterator position, size_type n, const T& x)
 {
+        link_type chain = list_node_allocator::allocate_chain(this->get_alloc(), n);
         for (; n > 0; --n)
-                insert(position, x);
+        {
+                link_type next = list_node_allocator::chain_next(chain);
+                try {
+                        construct(&chain->data, x);
+                }
+                catch(...) {
+                        put_chain(chain, n);
+                        throw;
+                }
+                link_node(position, chain);
+                chain = next;
+        }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
+template <typename InputIterator>
+void
+list<T, Alloc>::insert_chain(iterator position, InputIterator first, size_type n)
+{
+        link_type chain = list_node_allocator::allocate_chain(this->get_alloc(), n);
+        for (; n > 0; --n, ++first)
+        {
+                link_type next = list_node_allocator::chain_next(chain);
+                try {
+                        construct(&chain->data, *first);
+                }
+                catch(...) {
+                        put_chain(chain, n);
+                        throw;
+                }
+                link_node(position, chain);
+                chain = next;
+        }
+}
+
+template <typename T, typename Alloc>
 void
-list<T>::insert(iterator position, iterator first, iterator last)
+list<T, Alloc>::insert(iterator position, iterator first, iterator last)
 {
-        for(; first != last; ++first)
-                insert(position, *first);
+        insert_chain(position, first, (size_type)SimSTL::distance(first, last));
 }
 
-template <typename T>
-typename list<T>::iterator
-list<T>::erase(iterator position)
+template <typename T, typename Alloc>
+void
+list<T, Alloc>::insert(iterator position, const_iterator first, const_iterator last)
 {
-        link_type next_node = (link_type)position.node->next;
-        link_type prev_node = (link_type)position.node->prev;
+        insert_chain(position, first, (size_type)SimSTL::distance(first, last));
+}
+
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::erase(iterator position)
+{
+        base_ptr next_node = (base_ptr)position.node->next;
+        base_ptr prev_node = (base_ptr)position.node->prev;
         prev_node->next = next_node;
         next_node->prev = prev_node;
-        destroy_node(position);
+        --length;
+        destroy_node((link_type)position.node);
         return (iterator)next_node;
 }
 
-template <typename T>
-typename list<T>::iterator
-list<T>::erase(iterator first, iterator last)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::erase(iterator first, iterator last)
 {
         while (first != last)
                 erase(first++);
         return last;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::clear()
+list<T, Alloc>::clear()
 {
-        link_type cur = (link_type)node->next;
-        while (cur != node)
+        //析构元素的同时把节点串成区块链，最后一次归还配置器
+        if (empty())
+                return ;
+        link_type first = (link_type)node.next;
+        link_type last = first;
+        size_type n = 0;
+        base_ptr cur = first;
+        while (cur != &node)
         {
-                link_type tmp = cur;
-                cur = cur->next;
-                destroy_node(tmp);
+                base_ptr next = (base_ptr)cur->next;
+                last = (link_type)cur;
+                destroy(&last->data);
+                if (next != &node)
+                        list_node_allocator::chain_link(last, (link_type)next);
+                cur = next;
+                ++n;
         }
-        node->prev = node;
-        node->next = node;
+        list_node_allocator::deallocate_chain(this->get_alloc(), first, last, n);
+        empty_initialize();
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::remove(const T& x)
+list<T, Alloc>::remove(const T& x)
 {
         iterator first = begin();
         iterator last = end();
@@ -294,9 +629,9 @@ list<T>::remove(const T& x)
         }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::unique()
+list<T, Alloc>::unique()
 {
         iterator first = begin();
         iterator last = end();
@@ -310,37 +645,62 @@ list<T>::unique()
         }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::splice(iterator position, list<T>& x)
+list<T, Alloc>::splice(iterator position, list& x)
 {
         if (!x.empty())
+        {
                 transfer(position, x.begin(), x.end());
+                length += x.length;
+                x.length = 0;
+        }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-splice(iterator position, list<T>& x, iterator i)
+list<T, Alloc>::splice(iterator position, list& x, iterator i)
 {
-        iterator next = i;
-        ++next;
+        iterator j = i;
+        ++j;
         if (position == i || position == j)
                 return ;
-        transfer(position, first, last);
+        transfer(position, i, j);
+        ++length;
+        --x.length;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-splice(iterator position, list<T>& x, iterator first, iterator last)
+list<T, Alloc>::splice(iterator position, list& x, iterator first, iterator last)
 {
-        if (first != last)
-                transfer(position, first, last);
+        if (first == last)
+                return ;
+        //同一个list内搬移时元素个数不变，不必计算区间长度
+        const size_type n = &x == this ? 0 : (size_type)SimSTL::distance(first, last);
+        splice(position, x, first, last, n);
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::merge(list<T>& x) //前提两个list都已递增排序
+list<T, Alloc>::splice(iterator position, list& x, iterator first, iterator last, size_type n)
 {
+        if (first == last)
+                return ;
+        transfer(position, first, last);
+        if (&x != this)
+        {
+                length += n;
+                x.length -= n;
+        }
+}
+
+template <typename T, typename Alloc>
+void
+list<T, Alloc>::merge(list& x) //前提两个list都已递增排序
+{
+        if (this == &x)
+                return ;
         iterator first1 = begin();
         iterator last1 = end();
         iterator first2 = x.begin();
@@ -359,15 +719,17 @@ list<T>::merge(list<T>& x) //前提两个list都已递增排序
         }
         if (first2 != last2)
                 transfer(last1, first2, last2);
+        length += x.length;
+        x.length = 0;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::reverse()
+list<T, Alloc>::reverse()
 {
-        if (node->next == node || link_type(node->next)->next == node)
+        if (node.next == &node || base_ptr(node.next)->next == &node)
                 return ;
-        iteraotr first = begin();
+        iterator first = begin();
         ++first;
         while (first != end())
         {
@@ -377,53 +739,236 @@ list<T>::reverse()
         }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 void
-list<T>::swap(list<T>& x)
+list<T, Alloc>::swap(list& x)
 {
-        std::swap(node, x.node);
+        SimSTL::swap(this->get_alloc(), x.get_alloc());
+        swap_nodes(x);
 }
 
-template <typename T>
+template <typename T, typename Alloc>
+void
+list<T, Alloc>::swap_nodes(list& x)
+{
+        const bool this_empty = empty();
+        const bool x_empty = x.empty();
+        SimSTL::swap(node.next, x.node.next);
+        SimSTL::swap(node.prev, x.node.prev);
+        SimSTL::swap(length, x.length);
+        if (x_empty)
+                empty_initialize();
+        else
+                ((base_ptr)node.next)->prev = ((base_ptr)node.prev)->next = &node;
+        if (this_empty)
+                x.empty_initialize();
+        else
+                ((base_ptr)x.node.next)->prev = ((base_ptr)x.node.prev)->next = &x.node;
+}
+
+template <typename T, typename Alloc>
 inline void
-swap(list<T>& x, list<T>& y)
+swap(list<T, Alloc>& x, list<T, Alloc>& y)
 {
         x.swap(y);
 }
 
-template <typename T>
+template <typename T, typename Alloc>
+template <typename Compare>
 void
-list<T>::sort()
+list<T, Alloc>::merge_runs(link_type& a, link_type& b, Compare& comp)
 {
-        if (node->next = node || linke_type(node->next)->next = node)
-                return ;
-        list<T> carry;
-        list<T> count[64];
+        void *result;
+        void **tail = &result;
+        link_type x = a;
+        link_type y = b;
+        try {
+                while (x != NULL && y != NULL)
+                {
+                        if (comp(y->data, x->data))
+                        {
+                                *tail = y;
+                                tail = &y->next;
+                                y = (link_type)y->next;
+                        }
+                        else
+                        {
+                                *tail = x;
+                                tail = &x->next;
+                                x = (link_type)x->next;
+                        }
+                }
+        }
+        catch(...) {
+                //已合并的部分之后接上两条链剩下的节点，一个也不丢
+                *tail = x;
+                while (*tail != NULL)
+                        tail = &((link_type)*tail)->next;
+                *tail = y;
+                a = (link_type)result;
+                b = NULL;
+                throw;
+        }
+        *tail = x != NULL ? x : y;
+        a = (link_type)result;
+        b = NULL;
+}
+
+//自底向上的归并排序：counter[i]是长度为2^i的有序节点链，只改动节点指针，
+//不需要临时list，也就不向配置器申请空白节点；最后一次补全prev指针。
+//比较抛出异常时，各条有序链和尚未取出的节点重新链回list，元素不会丢失，但顺序不确定
+template <typename T, typename Alloc>
+template <typename Compare>
+void
+list<T, Alloc>::merge_sort_nodes(Compare& comp)
+{
+        link_type counter[64];
         int fill = 0;
-        while (!empty())
-        {
-                carry.splice(carry.begin(), *this, begin());
-                int i = 0;
-                while (i < fill && !counter[i].empty())
+        link_type carry = NULL;
+        link_type result = NULL;
+        base_ptr cur = (base_ptr)node.next;
+        base_ptr tail = &node;
+        try {
+                while (cur != &node)
+                {
+                        carry = (link_type)cur;
+                        cur = (base_ptr)cur->next;
+                        carry->next = NULL;
+                        int i = 0;
+                        while (i < fill && counter[i] != NULL)
+                        {
+                                merge_runs(counter[i], carry, comp);  //counter[i]中的元素在前
+                                carry = counter[i];
+                                counter[i++] = NULL;
+                        }
+                        if (i == fill)
+                                ++fill;
+                        counter[i] = carry;
+                        carry = NULL;
+                }
+
+                for (int i = 0; i < fill; ++i)
                 {
-                        counter[i].merge(carry);
-                        carry.swap(counter[i++]);
+                        if (counter[i] != NULL)
+                        {
+                                merge_runs(counter[i], result, comp);
+                                result = counter[i];
+                                counter[i] = NULL;
+                        }
                 }
-                carry.swap(counter[i]);
-                if (i == fill)
-                        ++fill;
+        }
+        catch(...) {
+                append_chain(tail, carry);
+                append_chain(tail, result);
+                for (int i = 0; i < fill; ++i)
+                        append_chain(tail, counter[i]);
+                for (; cur != &node; cur = (base_ptr)cur->next)  //尚未取出的节点仍按next串到空白节点
+                {
+                        cur->prev = tail;
+                        tail->next = cur;
+                        tail = cur;
+                }
+                tail->next = &node;
+                node.prev = tail;
+                throw;
         }
 
-        for (int i = 1; i < fill; ++i)
-                counter[i].merge(counter[i - 1]);
-        swap(counter[fill - 1]);
+        append_chain(tail, result);
+        tail->next = &node;
+        node.prev = tail;
 }
 
-template <typename T>
+//合并时依次访问的是连续的指针数组，比沿next逐个取节点少得多的cache miss。
+//比较抛出异常时节点还没有重新链接，list保持不变
+template <typename T, typename Alloc>
+template <typename Compare>
+bool
+list<T, Alloc>::gather_sort_aux(Compare& comp, size_t threads)
+{
+        const size_type n = length;
+        link_type *buf = (link_type *)malloc(2 * n * sizeof(link_type));
+        if (buf == NULL)
+                return false;
+
+        link_type *p = buf;
+        for (base_ptr cur = (base_ptr)node.next; cur != &node; cur = (base_ptr)cur->next)
+                *p++ = (link_type)cur;
+
+        link_type *sorted;
+        try {
+#ifdef __SIMSTL_THREADS
+                if (threads > 1)
+                        sorted = __list_ptr_parallel_sort(buf, buf + n, n, comp, threads);
+                else
+#else
+                (void)threads;
+#endif
+                        sorted = __list_ptr_merge_sort(buf, buf + n, n, comp);
+        }
+        catch(...) {
+                free(buf);
+                throw;
+        }
+
+        base_ptr prev = &node;
+        for (size_type i = 0; i < n; ++i)
+        {
+                sorted[i]->prev = prev;
+                prev->next = sorted[i];
+                prev = sorted[i];
+        }
+        prev->next = &node;
+        node.prev = prev;
+        free(buf);
+        return true;
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void
+list<T, Alloc>::sort(Compare comp)
+{
+        if (length >= 2)
+                merge_sort_nodes(comp);
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void
+list<T, Alloc>::gather_sort(Compare comp)
+{
+        if (length >= 2 && !gather_sort_aux(comp, 1))
+                merge_sort_nodes(comp);
+}
+
+#ifdef __SIMSTL_THREADS
+template <typename T, typename Alloc>
+template <typename Compare>
+void
+list<T, Alloc>::parallel_sort(Compare comp, unsigned threads)
+{
+        if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+        size_type chunks = length / __SIMSTL_LIST_PARALLEL_SORT_GRAIN;
+        if (chunks > threads)
+                chunks = threads;
+        if (chunks > 64)
+                chunks = 64;
+        if (chunks < 2)
+        {
+                sort(comp);
+                return ;
+        }
+        if (!gather_sort_aux(comp, chunks))
+                merge_sort_nodes(comp);
+}
+#endif
+
+template <typename T, typename Alloc>
 inline bool
-operator==(const list<T>& x, const list<T>& y)
+operator==(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
-        typedef typename list<T>::const_iterator const_iterator;
+        typedef typename list<T, Alloc>::const_iterator const_iterator;
         const_iterator first1 = x.begin();
         const_iterator last1 = x.end();
         const_iterator first2 = y.begin();
@@ -437,16 +982,16 @@ operator==(const list<T>& x, const list<T>& y)
         return first1 == last1 && first2 == last2;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 inline bool
-operator!=(const list<T>& x, const list<T>& y)
+operator!=(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
-        return !(x == y)
+        return !(x == y);
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 inline bool
-operator<(const list<T>& x, const list<T>& y)
+operator<(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
         if (x.size() < y.size())
                 return true;
@@ -454,10 +999,10 @@ operator<(const list<T>& x, const list<T>& y)
                 return false;
         else
         {
-                typedef typename list<T>::const_iterator const_iterator;
+                typedef typename list<T, Alloc>::const_iterator const_iterator;
                 const_iterator first1 = x.begin();
                 const_iterator first2 = y.begin();
-                size_type n = x.size();
+                typename list<T, Alloc>::size_type n = x.size();
                 for (; n > 0; --n)
                 {
                         if (*first1 == *first2)
@@ -475,23 +1020,23 @@ operator<(const list<T>& x, const list<T>& y)
         }
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 inline bool
-operator>(const list<T>& x, const list<T>& y)
+operator>(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
         return y < x;
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 inline bool
-operator<=(const list<T>& x, const list<T>& y)
+operator<=(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
         return !(y < x);
 }
 
-template <typename T>
+template <typename T, typename Alloc>
 inline bool
-operator>=(const list<T>& x, const list<T>& y)
+operator>=(const list<T, Alloc>& x, const list<T, Alloc>& y)
 {
         return !(x < y);
 }
@@ -0,0 +1,395 @@
+#ifndef _MMAP_VECTOR_H_
+#define _MMAP_VECTOR_H_
+
+#include "simalgobase.h"
+#include "simconstruct.h"
+#include "simiterator.h"
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <system_error>
+#include <type_traits>
+#include <utility> //for std::forward
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SimSTL {
+
+
+//以内存映射文件为存储的vector，元素按字节保存，T必须可以按字节复制。
+//文件开头是64字节的header（标识、元素大小、元素个数），其后紧接元素：
+//打开已有文件时直接映射，不做反序列化；扩容时用ftruncate加长文件再mremap。
+//元素个数在sync和close时写回header，sync之后的内容才保证落盘。
+//与vector相同，扩容会使指针和迭代器失效。扩容前必须已经open成功；
+//加长文件或重新映射失败（如磁盘已满）时抛出std::system_error，mmap_vector保持不变
+template <typename T>
+class mmap_vector
+{
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "mmap_vector stores raw bytes, T must be trivially copyable");
+        static_assert(alignof(T) <= 64, "mmap_vector aligns elements to at most 64 bytes");
+
+public:
+        typedef T                       value_type;
+        typedef value_type*             pointer;
+        typedef const value_type*       const_pointer;
+        typedef value_type*             iterator;
+        typedef const value_type*       const_iterator;
+        typedef value_type&             reference;
+        typedef const value_type&       const_reference;
+        typedef size_t                  size_type;
+        typedef ptrdiff_t               difference_type;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+
+private:
+        struct header
+        {
+                char magic[8];
+                uint64_t elem_size;
+                uint64_t count;
+                char pad[40];
+        };
+
+        static_assert(sizeof(header) == 64, "mmap_vector header must stay 64 bytes");
+
+        int             fd;
+        char            *base;     //映射的起始地址，即header
+        size_t          mapped;    //映射的字节数，等于文件长度
+        iterator        start;
+        iterator        finish;
+        iterator        end_of_storage;
+
+private:
+        static const char *MAGIC() { return "SIMSTLMV"; }
+
+        static size_t ROUND_PAGE(size_t bytes)
+        {
+                size_t page = (size_t)sysconf(_SC_PAGESIZE);
+                return (bytes + page - 1) & ~(page - 1);
+        }
+
+        header *get_header() const { return (header *)base; }
+
+        //文件已是bytes字节，重新映射并保持元素个数
+        bool remap(size_t bytes)
+        {
+                const size_type count = size();
+                void *p;
+                if (base == NULL)
+                        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                else
+                {
+#ifdef MREMAP_MAYMOVE
+                        p = mremap(base, mapped, bytes, MREMAP_MAYMOVE);
+#else
+                        //没有mremap时整体映射新的长度，成功后再解除旧映射
+                        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                        if (p != MAP_FAILED)
+                                munmap(base, mapped);
+#endif
+                }
+                if (p == MAP_FAILED)
+                        return false;
+                base = (char *)p;
+                mapped = bytes;
+                start = (iterator)(base + sizeof(header));
+                finish = start + count;
+                end_of_storage = start + (bytes - sizeof(header)) / sizeof(T);
+                return true;
+        }
+
+        static void throw_io_error(int err, const char *what)
+        {
+                throw std::system_error(err, std::system_category(), what);
+        }
+
+        //容量改为至少n个元素，文件长度按页取整。失败时恢复文件长度并抛出异常，原映射不变
+        void change_capacity(size_type n)
+        {
+                assert(is_open() && "mmap_vector used before a successful open");
+                size_t bytes = ROUND_PAGE(sizeof(header) + n * sizeof(T));
+                if (ftruncate(fd, bytes) != 0)
+                        throw_io_error(errno, "mmap_vector: ftruncate");
+                if (!remap(bytes))
+                {
+                        const int err = errno;
+                        int ret = ftruncate(fd, mapped);
+                        (void)ret;
+                        throw_io_error(err, "mmap_vector: mremap");
+                }
+        }
+
+        size_type next_capacity(size_type n) const
+        {
+                return SimSTL::max(2 * capacity(), size() + n);
+        }
+
+        void reset()
+        {
+                fd = -1;
+                base = NULL;
+                mapped = 0;
+                start = finish = end_of_storage = 0;
+        }
+
+        bool open_failed()
+        {
+                if (base != NULL)
+                        munmap(base, mapped);
+                ::close(fd);
+                reset();
+                return false;
+        }
+
+        mmap_vector(const mmap_vector&);
+        mmap_vector& operator=(const mmap_vector&);
+
+public:
+        mmap_vector() { reset(); }
+
+        explicit mmap_vector(const char *path)
+        {
+                reset();
+                open(path);
+        }
+
+        mmap_vector(mmap_vector&& x)
+            : fd(x.fd), base(x.base), mapped(x.mapped),
+              start(x.start), finish(x.finish), end_of_storage(x.end_of_storage)
+        {
+                x.reset();
+        }
+
+        ~mmap_vector() { close(); }
+
+        mmap_vector& operator=(mmap_vector&& x)
+        {
+                if (this != &x)
+                {
+                        close();
+                        fd = x.fd;
+                        base = x.base;
+                        mapped = x.mapped;
+                        start = x.start;
+                        finish = x.finish;
+                        end_of_storage = x.end_of_storage;
+                        x.reset();
+                }
+                return *this;
+        }
+
+        void swap(mmap_vector& x)
+        {
+                SimSTL::swap(fd, x.fd);
+                SimSTL::swap(base, x.base);
+                SimSTL::swap(mapped, x.mapped);
+                SimSTL::swap(start, x.start);
+                SimSTL::swap(finish, x.finish);
+                SimSTL::swap(end_of_storage, x.end_of_storage);
+        }
+
+        //打开或创建path。已有文件的header与T不符（标识或元素大小不同、长度不足）时返回false
+        bool open(const char *path);
+
+        //写回元素个数并把文件截到实际长度，然后解除映射
+        void close();
+
+        //写回元素个数并msync，wait为false时只发起异步写回
+        bool sync(bool wait = true)
+        {
+                if (base == NULL)
+                        return false;
+                get_header()->count = size();
+                return msync(base, mapped, wait ? MS_SYNC : MS_ASYNC) == 0;
+        }
+
+        bool is_open() const { return fd >= 0; }
+
+public:
+        iterator begin() { return start; }
+        iterator end() { return finish; }
+        const_iterator begin() const { return start; }
+        const_iterator end() const { return finish; }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        reverse_iterator rbegin() const { return reverse_iterator(end()); }
+        reverse_iterator rend() const { return reverse_iterator(begin()); }
+        size_t size() const { return size_type(end() - begin()); }
+        bool empty() const { return begin() == end(); }
+        size_t capacity() const { return size_type(end_of_storage - begin()); }
+        reference operator[](size_type n) { return *(begin() + n); }
+        const_reference operator[](size_type n) const { return *(begin() + n); }
+        pointer data() { return start; }
+        const_pointer data() const { return start; }
+
+        reference front() { return *begin(); }
+        const_reference front() const { return *begin(); }
+        reference back() { return *(end() - 1); }
+        const_reference back() const { return *(end() - 1); }
+
+        void reserve(size_type n)
+        {
+                if (n > capacity())
+                        change_capacity(n);
+        }
+
+        //文件截到当前元素个数所需的页数
+        void shrink_to_fit() { change_capacity(size()); }
+
+public:
+        void push_back(const T& x)
+        {
+                if (finish == end_of_storage)
+                {
+                        T x_copy = x;  //扩容后x所在的映射可能失效
+                        change_capacity(next_capacity(1));
+                        *finish++ = x_copy;
+                }
+                else
+                        *finish++ = x;
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+                T x(std::forward<Args>(args)...);
+                push_back(x);
+        }
+
+        void pop_back() { --finish; }
+
+        iterator insert(iterator position, const T& x)
+        {
+                const size_type offset = position - start;
+                T x_copy = x;
+                if (finish == end_of_storage)
+                        change_capacity(next_capacity(1));
+                position = start + offset;
+                memmove((void *)(position + 1), (void *)position, (finish - position) * sizeof(T));
+                *position = x_copy;
+                ++finish;
+                return position;
+        }
+
+        iterator erase(iterator position) { return erase(position, position + 1); }
+
+        iterator erase(iterator first, iterator last)
+        {
+                memmove((void *)first, (void *)last, (finish - last) * sizeof(T));
+                finish -= last - first;
+                return first;
+        }
+
+        //在尾端追加n个元素，内容未初始化，返回指向第一个新元素的指针
+        pointer append_uninitialized(size_type n)
+        {
+                if (size_type(end_of_storage - finish) < n)
+                        change_capacity(next_capacity(n));
+                pointer result = finish;
+                finish += n;
+                return result;
+        }
+
+        void resize(size_type new_size, const T& val)
+        {
+                if (new_size <= size())
+                {
+                        finish = start + new_size;
+                        return ;
+                }
+                T x_copy = val;
+                const size_type n = new_size - size();
+                pointer p = append_uninitialized(n);
+                for (size_type i = 0; i < n; ++i)
+                        p[i] = x_copy;
+        }
+
+        void resize(size_type new_size) { resize(new_size, T()); }
+
+        //新增的元素保留文件中原有的字节（新扩展的文件区域为0）
+        void resize(size_type new_size, default_init_t)
+        {
+                if (new_size <= size())
+                        finish = start + new_size;
+                else
+                        append_uninitialized(new_size - size());
+        }
+
+        void clear() { finish = start; }
+};
+
+template <typename T>
+bool
+mmap_vector<T>::open(const char *path)
+{
+        close();
+        fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+        {
+                reset();
+                return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+                return open_failed();
+
+        size_t bytes = (size_t)st.st_size;
+        if (bytes == 0)  //新文件
+        {
+                bytes = ROUND_PAGE(sizeof(header));
+                if (ftruncate(fd, bytes) != 0 || !remap(bytes))
+                        return open_failed();
+                header *h = get_header();
+                memcpy(h->magic, MAGIC(), sizeof(h->magic));
+                h->elem_size = sizeof(T);
+                h->count = 0;
+                return true;
+        }
+
+        if (bytes < sizeof(header) || !remap(bytes))
+                return open_failed();
+        header *h = get_header();
+        if (memcmp(h->magic, MAGIC(), sizeof(h->magic)) != 0
+            || h->elem_size != sizeof(T) || h->count > capacity())
+                return open_failed();
+        finish = start + h->count;
+        return true;
+}
+
+template <typename T>
+void
+mmap_vector<T>::close()
+{
+        if (fd < 0)
+                return ;
+        const size_t bytes = sizeof(header) + size() * sizeof(T);
+        get_header()->count = size();
+        munmap(base, mapped);
+        //截短失败时文件保留多余的容量，header中的元素个数仍然正确
+        int ret = ftruncate(fd, bytes);
+        (void)ret;
+        ::close(fd);
+        reset();
+}
+
+template <typename T>
+inline void
+swap(mmap_vector<T>& x, mmap_vector<T>& y)
+{
+        x.swap(y);
+}
+
+
+}
+
+#endif
+
+#endif
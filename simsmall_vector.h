@@ -0,0 +1,487 @@
+#ifndef _SMALL_VECTOR_H_
+#define _SMALL_VECTOR_H_
+
+#include "simconstruct.h"
+#include "simalloc.h"
+#include "simiterator.h"
+#include "simuninitialized.h"
+#include <cstddef>
+#include <cstring> //for memcpy
+#include <type_traits> //for std::is_nothrow_move_constructible
+#include <utility> //for std::move, std::forward
+
+namespace SimSTL {
+
+//至多N个元素存放在对象内部的缓冲区，超出后才向Alloc申请空间，接口与vector相同。
+//start指向内部缓冲区时元素在对象内，移动和swap需要逐个搬移元素。
+//与vector相同，有状态的配置器保存在对象中，随堆上的空间一起复制、移动和交换
+template <typename T, size_t N, typename Alloc = alloc>
+class small_vector : private __alloc_holder<Alloc>
+{
+        static_assert(N > 0, "small_vector needs at least one inline element");
+
+public:
+        typedef T                       value_type;
+        typedef value_type*             pointer;
+        typedef const value_type*       const_pointer;
+        typedef value_type*             iterator;
+        typedef const value_type*       const_iterator;
+        typedef value_type&             reference;
+        typedef const value_type&       const_reference;
+        typedef size_t                  size_type;
+        typedef ptrdiff_t               difference_type;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+        typedef Alloc allocator_type;
+
+        allocator_type get_allocator() const { return this->get_alloc(); }
+
+
+private:
+        typedef simple_alloc<T, allocator_type> data_allocator;
+        typedef __alloc_holder<allocator_type> alloc_holder;
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+        iterator        start;
+        iterator        finish;
+        iterator        end_of_storage;
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+
+        enum { nothrow_move = std::is_nothrow_move_constructible<T>::value };
+
+private:
+        pointer allocate(size_t n)
+        {
+                return data_allocator::allocate(this->get_alloc(), n);
+        }
+
+        void deallocate(pointer p, size_t n)
+        {
+                data_allocator::deallocate(this->get_alloc(), p, n);
+        }
+
+        pointer inline_storage() { return (pointer)buffer; }
+
+        bool is_inline() const { return start == (const_pointer)buffer; }
+
+        void reset_inline()
+        {
+                start = finish = inline_storage();
+                end_of_storage = start + N;
+        }
+
+        void release_storage()
+        {
+                if (!is_inline())
+                        deallocate(start, capacity());
+        }
+
+        //把[first, last)搬到result开始的未初始化空间，原区间的元素随之析构（或放弃）
+        static iterator relocate(iterator first, iterator last, iterator result, __true_type)
+        {
+                memcpy((void *)result, (void *)first, (last - first) * sizeof(T));
+                return result + (last - first);
+        }
+
+        static iterator relocate(iterator first, iterator last, iterator result, __false_type)
+        {
+                iterator new_finish = SimSTL::uninitialized_move_if_noexcept(first, last, result);
+                SimSTL::destroy(first, last);
+                return new_finish;
+        }
+
+        //再放入n个元素时扩容后的容量
+        size_type next_capacity(size_type n) const
+        {
+                return SimSTL::max(2 * capacity(), size() + n);
+        }
+
+        //把元素搬到容量为len的新空间，len不超过N时搬回内部缓冲区
+        void relocate_storage(size_type len);
+
+        template <typename... Args>
+        void grow_emplace_back(Args&&... args);
+
+        //以下两个函数在构造函数中初始化刚reset_inline的small_vector。
+        //构造失败时析构函数不会执行，所以构造元素失败要先归还reserve配置的空间
+        void fill_initialize(size_type n, const T& value)
+        {
+                reserve(n);
+                try {
+                        finish = SimSTL::uninitialized_fill_n(start, n, value);
+                }
+                catch(...) {
+                        release_storage();
+                        throw;
+                }
+        }
+
+        void copy_initialize(const_iterator first, const_iterator last)
+        {
+                reserve(last - first);
+                try {
+                        finish = SimSTL::uninitialized_copy(first, last, start);
+                }
+                catch(...) {
+                        release_storage();
+                        throw;
+                }
+        }
+
+        //从x接管元素和配置器，*this为空且使用内部缓冲区
+        void take(small_vector& x) noexcept(nothrow_move);
+
+public:
+        small_vector() { reset_inline(); }
+
+        explicit small_vector(const allocator_type& a) : alloc_holder(a) { reset_inline(); }
+
+        explicit small_vector(size_type n, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                reset_inline();
+                fill_initialize(n, T());
+        }
+
+        small_vector(size_type n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                reset_inline();
+                fill_initialize(n, value);
+        }
+
+        small_vector(int n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                reset_inline();
+                fill_initialize(size_type(n), value);
+        }
+
+        small_vector(long n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                reset_inline();
+                fill_initialize(size_type(n), value);
+        }
+
+        small_vector(const_iterator first, const_iterator last,
+                     const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                reset_inline();
+                copy_initialize(first, last);
+        }
+
+        small_vector(const small_vector& x) : alloc_holder(x.get_alloc())
+        {
+                reset_inline();
+                copy_initialize(x.begin(), x.end());
+        }
+
+        small_vector(small_vector&& x) noexcept(nothrow_move)
+            : alloc_holder(x.get_alloc())
+        {
+                reset_inline();
+                take(x);
+        }
+
+        ~small_vector()
+        {
+                SimSTL::destroy(start, finish);
+                release_storage();
+        }
+
+        small_vector& operator=(const small_vector& x)
+        {
+                if (this != &x)
+                {
+                        small_vector tmp(x);
+                        clear();
+                        release_storage();
+                        reset_inline();
+                        take(tmp);
+                }
+                return *this;
+        }
+
+        small_vector& operator=(small_vector&& x) noexcept(nothrow_move)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        release_storage();
+                        reset_inline();
+                        take(x);
+                }
+                return *this;
+        }
+
+        //两边都在堆上时只交换指针和配置器，否则逐个移动元素
+        void swap(small_vector& x) noexcept(nothrow_move)
+        {
+                if (!is_inline() && !x.is_inline())
+                {
+                        SimSTL::swap(this->get_alloc(), x.get_alloc());
+                        SimSTL::swap(start, x.start);
+                        SimSTL::swap(finish, x.finish);
+                        SimSTL::swap(end_of_storage, x.end_of_storage);
+                        return ;
+                }
+                small_vector tmp(std::move(x));
+                x = std::move(*this);
+                *this = std::move(tmp);
+        }
+
+
+public:
+        iterator begin() { return start; }
+        iterator end() { return finish; }
+        const_iterator begin() const { return start; }
+        const_iterator end() const { return finish; }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        reverse_iterator rbegin() const { return reverse_iterator(end()); }
+        reverse_iterator rend() const { return reverse_iterator(begin()); }
+        size_t size() const { return size_type(end() - begin()); }
+        bool empty() const { return begin() == end(); }
+        size_t capacity() const { return size_type(end_of_storage - begin()); }
+        reference operator[](size_type n) { return *(begin() + n); }
+        const_reference operator[](size_type n) const { return *(begin() + n); }
+
+        //元素是否在对象内部的缓冲区中
+        bool is_small() const { return is_inline(); }
+
+        //容量至少为n，不会缩小
+        void reserve(size_type n)
+        {
+                if (n > capacity())
+                        relocate_storage(n);
+        }
+
+        //释放多余的容量，元素个数不超过N时搬回内部缓冲区
+        void shrink_to_fit()
+        {
+                if (!is_inline() && capacity() != size())
+                        relocate_storage(size());
+        }
+
+public:
+        reference front() { return *begin(); }
+        const_reference front() const { return *begin(); }
+        reference back() { return *(end() - 1); }
+        const_reference back() const { return *(end() - 1); }
+
+        void insert(iterator position, size_type n, const T& x);
+        iterator insert(iterator position, const T& x) { return emplace(position, x); }
+        iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+
+        void push_back(const T& val) { emplace_back(val); }
+        void push_back(T&& val) { emplace_back(std::move(val)); }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+                if (finish != end_of_storage)
+                {
+                        construct(finish, std::forward<Args>(args)...);
+                        ++finish;
+                }
+                else
+                        grow_emplace_back(std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        iterator emplace(iterator position, Args&&... args);
+
+        void pop_back()
+        {
+                --finish;
+                SimSTL::destroy(finish);
+        }
+
+        iterator erase(iterator position) { return erase(position, position + 1); }
+
+        iterator erase(iterator first, iterator last)
+        {
+                iterator i = SimSTL::move(last, finish, first);
+                SimSTL::destroy(i, finish);
+                finish = i;
+                return first;
+        }
+
+        void resize(size_t new_size, const T& val)
+        {
+                if (new_size < size())
+                        erase(begin() + new_size, end());
+                else
+                        insert(end(), new_size - size(), val);
+        }
+
+        void resize(size_t new_size) { resize(new_size, T()); }
+
+        void resize(size_t new_size, default_init_t)
+        {
+                if (new_size < size())
+                        erase(begin() + new_size, end());
+                else
+                        append_uninitialized(new_size - size());
+        }
+
+        pointer append_uninitialized(size_type n)
+        {
+                if (size_type(end_of_storage - finish) < n)
+                        relocate_storage(next_capacity(n));
+                pointer result = finish;
+                finish = uninitialized_default_n(finish, n);
+                return result;
+        }
+
+        void clear() { erase(begin(), end()); }
+};
+
+template <typename T, size_t N, typename Alloc>
+void
+small_vector<T, N, Alloc>::relocate_storage(size_type len)
+{
+        iterator new_start;
+        if (len <= N)
+        {
+                if (is_inline())
+                        return ;
+                new_start = inline_storage();
+                len = N;
+        }
+        else
+                new_start = allocate(len);
+
+        iterator new_finish;
+        try {
+                new_finish = relocate(start, finish, new_start, relocatable());
+        }
+        catch(...) {
+                if (len > N)
+                        deallocate(new_start, len);
+                throw;
+        }
+        release_storage();
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+}
+
+//与vector相同，先在新空间构造新元素，args可能引用旧空间中的元素
+template <typename T, size_t N, typename Alloc>
+template <typename... Args>
+void
+small_vector<T, N, Alloc>::grow_emplace_back(Args&&... args)
+{
+        const size_type old_size = size();
+        const size_type len = next_capacity(1);
+        iterator new_start = allocate(len);
+
+        try {
+                construct(new_start + old_size, std::forward<Args>(args)...);
+        }
+        catch(...) {
+                deallocate(new_start, len);
+                throw;
+        }
+
+        try {
+                relocate(start, finish, new_start, relocatable());
+        }
+        catch(...) {
+                SimSTL::destroy(new_start + old_size);
+                deallocate(new_start, len);
+                throw;
+        }
+        release_storage();
+        start = new_start;
+        finish = new_start + old_size + 1;
+        end_of_storage = new_start + len;
+}
+
+template <typename T, size_t N, typename Alloc>
+template <typename... Args>
+typename small_vector<T, N, Alloc>::iterator
+small_vector<T, N, Alloc>::emplace(iterator position, Args&&... args)
+{
+        const size_type offset = position - start;
+        if (position == finish)
+        {
+                emplace_back(std::forward<Args>(args)...);
+                return start + offset;
+        }
+
+        T x_copy(std::forward<Args>(args)...);  //args可能引用将被移动的元素
+        if (finish == end_of_storage)
+                relocate_storage(next_capacity(1));
+        position = start + offset;
+        construct(finish, std::move(*(finish - 1)));
+        ++finish;
+        SimSTL::move_backward(position, finish - 2, finish - 1);
+        *position = std::move(x_copy);
+        return position;
+}
+
+template <typename T, size_t N, typename Alloc>
+void
+small_vector<T, N, Alloc>::insert(iterator position, size_type n, const T& x)
+{
+        if (n == 0)
+                return ;
+        const size_type offset = position - start;
+        T x_copy = x;
+        if (size_type(end_of_storage - finish) < n)
+                relocate_storage(next_capacity(n));
+        position = start + offset;
+
+        const size_type elems_after = finish - position;
+        iterator old_finish = finish;
+        if (elems_after > n)  //插入点之后的现有元素个数大于新增元素个数
+        {
+                SimSTL::uninitialized_move(finish - n, finish, finish);
+                finish += n;
+                SimSTL::move_backward(position, old_finish - n, old_finish);
+                SimSTL::fill(position, position + n, x_copy);
+        }
+        else
+        {
+                SimSTL::uninitialized_fill_n(finish, n - elems_after, x_copy);
+                finish += n - elems_after;
+                SimSTL::uninitialized_move(position, old_finish, finish);
+                finish += elems_after;
+                SimSTL::fill(position, old_finish, x_copy);
+        }
+}
+
+//x的元素在堆上时直接接管指针，在内部缓冲区时逐个移动
+template <typename T, size_t N, typename Alloc>
+void
+small_vector<T, N, Alloc>::take(small_vector& x) noexcept(nothrow_move)
+{
+        this->get_alloc() = x.get_alloc();
+        if (x.is_inline())
+        {
+                finish = SimSTL::uninitialized_move(x.start, x.finish, start);
+                x.clear();
+        }
+        else
+        {
+                start = x.start;
+                finish = x.finish;
+                end_of_storage = x.end_of_storage;
+                x.reset_inline();
+        }
+}
+
+template <typename T, size_t N, typename Alloc>
+inline void
+swap(small_vector<T, N, Alloc>& x, small_vector<T, N, Alloc>& y)
+{
+        x.swap(y);
+}
+
+}
+
+
+#endif
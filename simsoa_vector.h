@@ -0,0 +1,625 @@
+#ifndef _SOA_VECTOR_H_
+#define _SOA_VECTOR_H_
+
+#include "simalloc.h"
+#include "simalgobase.h"
+#include "simconstruct.h"
+#include "simiterator.h"
+#include "simuninitialized.h"
+#include <cstddef>
+#include <cstring> //for memcpy
+#include <type_traits>
+#include <utility> //for std::move, std::forward
+
+namespace SimSTL {
+
+
+//Ts中的第I个类型
+template <size_t I, typename... Ts>
+struct __soa_type;
+
+template <typename T, typename... Ts>
+struct __soa_type<0, T, Ts...>
+{
+        typedef T type;
+};
+
+template <size_t I, typename T, typename... Ts>
+struct __soa_type<I, T, Ts...> : public __soa_type<I - 1, Ts...> {};
+
+//按列保存的存储，每一层保存一列并派生自其余各列。
+//各列的元素个数与容量相同，由soa_vector记录
+template <typename Alloc, typename... Ts>
+struct __soa_columns
+{
+        enum { nothrow_move = 1 };
+
+        void allocate(size_t) {}
+        void deallocate(size_t) {}
+        void copy_to(__soa_columns&, size_t) const {}
+        void relocate_to(__soa_columns&, size_t) {}
+        template <typename MoveTag>
+        void relocate_to(__soa_columns&, size_t, MoveTag) {}
+        void destroy_relocated(size_t) {}
+        void construct_row(size_t) {}
+        void construct_default_row(size_t) {}
+        void destroy(size_t, size_t) {}
+        void move_rows(size_t, size_t, size_t) {}
+        void swap(__soa_columns&) {}
+};
+
+template <typename Alloc, typename T, typename... Rest>
+struct __soa_columns<Alloc, T, Rest...> : public __soa_columns<Alloc, Rest...>
+{
+        typedef __soa_columns<Alloc, Rest...>   rest_type;
+        typedef T                               value_type;
+        typedef simple_alloc<T, Alloc>          data_allocator;
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+
+        //这一列和其后各列搬移时都不会抛出异常
+        enum { nothrow_move = (std::is_same<relocatable, __true_type>::value
+                               || std::is_nothrow_move_constructible<T>::value)
+                              && rest_type::nothrow_move };
+
+        T *column;
+
+        __soa_columns() : column(0) {}
+
+        rest_type& rest() { return *this; }
+        const rest_type& rest() const { return *this; }
+
+        //为每一列配置n个元素的空间，失败时不留下已配置的列
+        void allocate(size_t n)
+        {
+                column = data_allocator::allocate(n);
+                try {
+                        rest().allocate(n);
+                }
+                catch(...) {
+                        data_allocator::deallocate(column, n);
+                        column = 0;
+                        throw;
+                }
+        }
+
+        void deallocate(size_t n)
+        {
+                if (column)
+                        data_allocator::deallocate(column, n);
+                column = 0;
+                rest().deallocate(n);
+        }
+
+        //把前n行复制到dst，失败时dst中不留下元素
+        void copy_to(__soa_columns& dst, size_t n) const
+        {
+                SimSTL::uninitialized_copy((const T *)column, (const T *)column + n, dst.column);
+                try {
+                        rest().copy_to(dst.rest(), n);
+                }
+                catch(...) {
+                        SimSTL::destroy(dst.column, dst.column + n);
+                        throw;
+                }
+        }
+
+        //把前n行搬到dst，失败时*this保持不变。成功后由destroy_relocated析构原来的元素。
+        //只要有一列的搬移可能抛出异常，各列就都复制过去，免得前面的列已被移走
+        void relocate_to(__soa_columns& dst, size_t n)
+        {
+                relocate_to(dst, n, std::integral_constant<bool, nothrow_move>());
+        }
+
+        template <typename MoveTag>
+        void relocate_to(__soa_columns& dst, size_t n, MoveTag tag)
+        {
+                relocate_column(dst.column, n, relocatable(), tag);
+                try {
+                        rest().relocate_to(dst.rest(), n, tag);
+                }
+                catch(...) {
+                        unrelocate_column(dst.column, n, relocatable());
+                        throw;
+                }
+        }
+
+        void destroy_relocated(size_t n)
+        {
+                destroy_relocated_column(n, relocatable());
+                rest().destroy_relocated(n);
+        }
+
+        //以args在第i行构造一个元素，每个参数对应一列
+        template <typename Arg, typename... Args>
+        void construct_row(size_t i, Arg&& arg, Args&&... args)
+        {
+                construct(column + i, std::forward<Arg>(arg));
+                try {
+                        rest().construct_row(i, std::forward<Args>(args)...);
+                }
+                catch(...) {
+                        SimSTL::destroy(column + i);
+                        throw;
+                }
+        }
+
+        //第i行的每一列都值初始化
+        void construct_default_row(size_t i)
+        {
+                construct(column + i);
+                try {
+                        rest().construct_default_row(i);
+                }
+                catch(...) {
+                        SimSTL::destroy(column + i);
+                        throw;
+                }
+        }
+
+        void destroy(size_t first, size_t last)
+        {
+                SimSTL::destroy(column + first, column + last);
+                rest().destroy(first, last);
+        }
+
+        //把[first, last)行移动赋值到result开始的各行
+        void move_rows(size_t first, size_t last, size_t result)
+        {
+                SimSTL::move(column + first, column + last, column + result);
+                rest().move_rows(first, last, result);
+        }
+
+        void swap(__soa_columns& x)
+        {
+                SimSTL::swap(column, x.column);
+                rest().swap(x.rest());
+        }
+
+private:
+        template <typename MoveTag>
+        void relocate_column(T *dst, size_t n, __true_type, MoveTag)
+        {
+                if (n != 0)
+                        memcpy((void *)dst, (void *)column, n * sizeof(T));
+        }
+
+        void relocate_column(T *dst, size_t n, __false_type, std::true_type)
+        {
+                SimSTL::uninitialized_move(column, column + n, dst);
+        }
+
+        //只能移动的列仍然移动，这时不保证失败后*this不变
+        void relocate_column(T *dst, size_t n, __false_type, std::false_type)
+        {
+                relocate_by_copy(dst, n, std::is_copy_constructible<T>());
+        }
+
+        void relocate_by_copy(T *dst, size_t n, std::true_type)
+        {
+                SimSTL::uninitialized_copy((const T *)column, (const T *)column + n, dst);
+        }
+
+        void relocate_by_copy(T *dst, size_t n, std::false_type)
+        {
+                SimSTL::uninitialized_move(column, column + n, dst);
+        }
+
+        void unrelocate_column(T *, size_t, __true_type) {}
+        void unrelocate_column(T *dst, size_t n, __false_type) { SimSTL::destroy(dst, dst + n); }
+
+        void destroy_relocated_column(size_t, __true_type) {}
+        void destroy_relocated_column(size_t n, __false_type) { SimSTL::destroy(column, column + n); }
+};
+
+//__soa_columns中保存第I列的那一层
+template <size_t I, typename Columns>
+struct __soa_column_at;
+
+template <typename Alloc, typename T, typename... Rest>
+struct __soa_column_at<0, __soa_columns<Alloc, T, Rest...> >
+{
+        typedef __soa_columns<Alloc, T, Rest...> type;
+};
+
+template <size_t I, typename Alloc, typename T, typename... Rest>
+struct __soa_column_at<I, __soa_columns<Alloc, T, Rest...> >
+    : public __soa_column_at<I - 1, __soa_columns<Alloc, Rest...> > {};
+
+//一列元素的视图，不拥有元素
+template <typename T>
+struct soa_column
+{
+        typedef T               value_type;
+        typedef T*              iterator;
+        typedef T&              reference;
+        typedef size_t          size_type;
+
+        T *first;
+        size_t count;
+
+        soa_column(T *p, size_t n) : first(p), count(n) {}
+
+        iterator begin() const { return first; }
+        iterator end() const { return first + count; }
+        T *data() const { return first; }
+        size_type size() const { return count; }
+        bool empty() const { return count == 0; }
+        reference operator[](size_type n) const { return first[n]; }
+};
+
+//Vec为soa_vector或const soa_vector时第I列元素的引用类型
+template <size_t I, typename Vec>
+struct __soa_ref
+{
+        typedef typename Vec::template column_type<I>::type& type;
+};
+
+template <size_t I, typename Vec>
+struct __soa_ref<I, const Vec>
+{
+        typedef const typename Vec::template column_type<I>::type& type;
+};
+
+//一行的代理对象，get<I>()取得这一行第I列的元素
+template <typename Vec>
+class soa_row
+{
+        Vec *vec;
+        size_t index;
+
+public:
+        soa_row(Vec *v, size_t n) : vec(v), index(n) {}
+
+        template <size_t I>
+        typename __soa_ref<I, Vec>::type get() const { return vec->template column<I>()[index]; }
+
+        size_t row() const { return index; }
+};
+
+template <size_t I, typename Vec>
+inline typename __soa_ref<I, Vec>::type
+get(const soa_row<Vec>& r)
+{
+        return r.template get<I>();
+}
+
+//按行遍历的迭代器，解引用得到soa_row代理对象
+template <typename Vec>
+struct __soa_iterator
+{
+        typedef __soa_iterator<Vec>     self;
+
+        typedef random_access_iterator_tag iterator_category;
+        typedef soa_row<Vec>    value_type;
+        typedef ptrdiff_t       difference_type;
+        typedef void            pointer;
+        typedef soa_row<Vec>    reference;
+
+        Vec *vec;
+        size_t index;
+
+        __soa_iterator() : vec(0), index(0) {}
+        __soa_iterator(Vec *v, size_t n) : vec(v), index(n) {}
+
+        bool operator==(const self& x) const { return index == x.index; }
+        bool operator!=(const self& x) const { return index != x.index; }
+        bool operator<(const self& x) const { return index < x.index; }
+        bool operator>(const self& x) const { return index > x.index; }
+        bool operator<=(const self& x) const { return index <= x.index; }
+        bool operator>=(const self& x) const { return index >= x.index; }
+
+        reference operator*() const { return reference(vec, index); }
+        reference operator[](difference_type n) const { return reference(vec, index + n); }
+
+        self& operator++() { ++index; return *this; }
+        self operator++(int)
+        {
+                self tmp = *this;
+                ++*this;
+                return tmp;
+        }
+        self& operator--() { --index; return *this; }
+        self operator--(int)
+        {
+                self tmp = *this;
+                --*this;
+                return tmp;
+        }
+        self& operator+=(difference_type n) { index += n; return *this; }
+        self& operator-=(difference_type n) { index -= n; return *this; }
+        self operator+(difference_type n) const { return self(vec, index + n); }
+        self operator-(difference_type n) const { return self(vec, index - n); }
+        difference_type operator-(const self& x) const { return difference_type(index - x.index); }
+};
+
+//结构数组（structure of arrays）：每个字段一列，各列分别连续存放。
+//只读取一两个字段的循环只把这几列载入cache，也便于向量化。
+//push_back和emplace_back按行放入，每个参数对应一列；column<I>()取得第I列。
+//扩容时各列一起搬移，使各列的指针、迭代器失效
+template <typename... Ts>
+class soa_vector
+{
+        static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+public:
+        typedef soa_vector<Ts...>                       self;
+        typedef size_t                                  size_type;
+        typedef ptrdiff_t                               difference_type;
+        typedef soa_row<self>                           reference;
+        typedef soa_row<const self>                     const_reference;
+        typedef __soa_iterator<self>                    iterator;
+        typedef __soa_iterator<const self>              const_iterator;
+        typedef alloc                                   allocator_type;
+
+        //第I列的元素类型
+        template <size_t I>
+        struct column_type
+        {
+                typedef typename __soa_type<I, Ts...>::type type;
+        };
+
+        static const size_t columns = sizeof...(Ts);
+
+private:
+        typedef __soa_columns<alloc, Ts...> storage_type;
+
+        storage_type    data;
+        size_type       count;
+        size_type       cap;
+
+        template <size_t I>
+        struct column_base
+        {
+                typedef typename __soa_column_at<I, storage_type>::type type;
+        };
+
+        size_type next_capacity(size_type n) const
+        {
+                return SimSTL::max(2 * cap, count + n);
+        }
+
+        void release()
+        {
+                data.destroy(0, count);
+                data.deallocate(cap);
+        }
+
+        //把各列搬到容量为len的新空间
+        void relocate_storage(size_type len);
+
+        template <typename... Args>
+        void grow_emplace_back(Args&&... args);
+
+public:
+        soa_vector() : count(0), cap(0) {}
+
+        explicit soa_vector(size_type n) : count(0), cap(0) { resize(n); }
+
+        soa_vector(const soa_vector& x) : count(0), cap(0)
+        {
+                if (x.count == 0)
+                        return ;
+                data.allocate(x.count);
+                try {
+                        x.data.copy_to(data, x.count);
+                }
+                catch(...) {
+                        data.deallocate(x.count);
+                        throw;
+                }
+                count = cap = x.count;
+        }
+
+        soa_vector(soa_vector&& x) : count(x.count), cap(x.cap)
+        {
+                data.swap(x.data);
+                x.count = x.cap = 0;
+        }
+
+        ~soa_vector() { release(); }
+
+        soa_vector& operator=(const soa_vector& x)
+        {
+                if (this != &x)
+                {
+                        soa_vector tmp(x);
+                        swap(tmp);
+                }
+                return *this;
+        }
+
+        soa_vector& operator=(soa_vector&& x)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        swap(x);
+                }
+                return *this;
+        }
+
+        void swap(soa_vector& x)
+        {
+                data.swap(x.data);
+                SimSTL::swap(count, x.count);
+                SimSTL::swap(cap, x.cap);
+        }
+
+public:
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, count); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, count); }
+        size_type size() const { return count; }
+        size_type capacity() const { return cap; }
+        bool empty() const { return count == 0; }
+        reference operator[](size_type n) { return reference(this, n); }
+        const_reference operator[](size_type n) const { return const_reference(this, n); }
+        reference front() { return reference(this, 0); }
+        const_reference front() const { return const_reference(this, 0); }
+        reference back() { return reference(this, count - 1); }
+        const_reference back() const { return const_reference(this, count - 1); }
+
+        //第I列的首元素地址，容量为0时为空指针
+        template <size_t I>
+        typename column_type<I>::type *column()
+        {
+                return static_cast<typename column_base<I>::type&>(data).column;
+        }
+
+        template <size_t I>
+        const typename column_type<I>::type *column() const
+        {
+                return static_cast<const typename column_base<I>::type&>(data).column;
+        }
+
+        //第I列的视图
+        template <size_t I>
+        soa_column<typename column_type<I>::type> column_span()
+        {
+                return soa_column<typename column_type<I>::type>(column<I>(), count);
+        }
+
+        template <size_t I>
+        soa_column<const typename column_type<I>::type> column_span() const
+        {
+                return soa_column<const typename column_type<I>::type>(column<I>(), count);
+        }
+
+        void reserve(size_type n)
+        {
+                if (n > cap)
+                        relocate_storage(n);
+        }
+
+        void shrink_to_fit()
+        {
+                if (cap != count)
+                        relocate_storage(count);
+        }
+
+public:
+        void push_back(const Ts&... values) { emplace_back(values...); }
+
+        //每个参数构造一列的新元素
+        template <typename... Args>
+        void emplace_back(Args&&... args)
+        {
+                static_assert(sizeof...(Args) == sizeof...(Ts),
+                              "soa_vector::emplace_back takes one argument per column");
+                if (count != cap)
+                {
+                        data.construct_row(count, std::forward<Args>(args)...);
+                        ++count;
+                }
+                else
+                        grow_emplace_back(std::forward<Args>(args)...);
+        }
+
+        void pop_back()
+        {
+                --count;
+                data.destroy(count, count + 1);
+        }
+
+        iterator erase(iterator position) { return erase(position, position + 1); }
+
+        iterator erase(iterator first, iterator last)
+        {
+                data.move_rows(last.index, count, first.index);
+                const size_type new_count = count - (last.index - first.index);
+                data.destroy(new_count, count);
+                count = new_count;
+                return first;
+        }
+
+        //新增的行各列都值初始化
+        void resize(size_type new_size)
+        {
+                if (new_size < count)
+                {
+                        data.destroy(new_size, count);
+                        count = new_size;
+                        return ;
+                }
+                reserve(new_size);
+                for (; count < new_size; ++count)
+                        data.construct_default_row(count);
+        }
+
+        void clear()
+        {
+                data.destroy(0, count);
+                count = 0;
+        }
+};
+
+template <typename... Ts>
+const size_t soa_vector<Ts...>::columns;
+
+template <typename... Ts>
+void
+soa_vector<Ts...>::relocate_storage(size_type len)
+{
+        storage_type new_data;
+        if (len != 0)
+        {
+                new_data.allocate(len);
+                try {
+                        data.relocate_to(new_data, count);
+                }
+                catch(...) {
+                        new_data.deallocate(len);
+                        throw;
+                }
+        }
+        data.destroy_relocated(count);
+        data.deallocate(cap);
+        data.swap(new_data);
+        cap = len;
+}
+
+//与vector相同，先在新空间构造新的一行，args可能引用旧空间中的元素
+template <typename... Ts>
+template <typename... Args>
+void
+soa_vector<Ts...>::grow_emplace_back(Args&&... args)
+{
+        const size_type len = next_capacity(1);
+        storage_type new_data;
+        new_data.allocate(len);
+
+        try {
+                new_data.construct_row(count, std::forward<Args>(args)...);
+        }
+        catch(...) {
+                new_data.deallocate(len);
+                throw;
+        }
+
+        try {
+                data.relocate_to(new_data, count);
+        }
+        catch(...) {
+                new_data.destroy(count, count + 1);
+                new_data.deallocate(len);
+                throw;
+        }
+        data.destroy_relocated(count);
+        data.deallocate(cap);
+        data.swap(new_data);
+        cap = len;
+        ++count;
+}
+
+template <typename... Ts>
+inline void
+swap(soa_vector<Ts...>& x, soa_vector<Ts...>& y)
+{
+        x.swap(y);
+}
+
+
+}
+
+#endif
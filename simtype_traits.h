@@ -14,6 +14,9 @@ struct __type_traits
         typedef __false_type has_trivial_assignment_operator;
         typedef __false_type has_trivial_destructor;
         typedef __false_type is_POD_type;
+        //可平凡搬移：按字节复制到新地址并放弃原对象（不析构）等价于移动构造后析构原对象。
+        //POD类型都满足，只持有堆内存指针、不指向自身的类也满足，可特化为__true_type
+        typedef __false_type is_trivially_relocatable;
 };
 
 template <>
@@ -24,6 +27,7 @@ struct __type_traits <bool>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -34,6 +38,7 @@ struct __type_traits <char>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -44,6 +49,7 @@ struct __type_traits <signed char>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -54,6 +60,7 @@ struct __type_traits <unsigned char>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -64,6 +71,7 @@ struct __type_traits <short>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -74,6 +82,7 @@ struct __type_traits <unsigned short>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -84,6 +93,7 @@ struct __type_traits <int>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -94,6 +104,7 @@ struct __type_traits <unsigned int>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -104,6 +115,7 @@ struct __type_traits <long>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -114,6 +126,7 @@ struct __type_traits <unsigned long>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -124,6 +137,7 @@ struct __type_traits <long long>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -134,6 +148,7 @@ struct __type_traits <unsigned long long>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -144,6 +159,7 @@ struct __type_traits <float>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -154,6 +170,7 @@ struct __type_traits <double>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 template <>
@@ -164,6 +181,7 @@ struct __type_traits <long double>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 //原生指针的特化版本
@@ -175,6 +193,7 @@ struct __type_traits <T*>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
 //原生const指针的特化版本
@@ -186,8 +205,30 @@ struct __type_traits <const T*>
         typedef __true_type has_trivial_assignment_operator;
         typedef __true_type has_trivial_destructor;
         typedef __true_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
 };
 
+//整数类型判断，用于区分容器的(n, value)与(first, last)两种参数形式
+template <typename T>
+struct __is_integer
+{
+        typedef __false_type integral;
+};
+
+template <> struct __is_integer<bool> { typedef __true_type integral; };
+template <> struct __is_integer<char> { typedef __true_type integral; };
+template <> struct __is_integer<signed char> { typedef __true_type integral; };
+template <> struct __is_integer<unsigned char> { typedef __true_type integral; };
+template <> struct __is_integer<wchar_t> { typedef __true_type integral; };
+template <> struct __is_integer<short> { typedef __true_type integral; };
+template <> struct __is_integer<unsigned short> { typedef __true_type integral; };
+template <> struct __is_integer<int> { typedef __true_type integral; };
+template <> struct __is_integer<unsigned int> { typedef __true_type integral; };
+template <> struct __is_integer<long> { typedef __true_type integral; };
+template <> struct __is_integer<unsigned long> { typedef __true_type integral; };
+template <> struct __is_integer<long long> { typedef __true_type integral; };
+template <> struct __is_integer<unsigned long long> { typedef __true_type integral; };
+
 }
 
 #endif
@@ -0,0 +1,273 @@
+#ifndef _UNINITIALIZED_H_
+#define _UNINITIALIZED_H_
+
+#include "simconstruct.h"
+#include "simalgobase.h"
+#include "simtype_traits.h"
+#include "simiterator_base.h"
+
+namespace SimSTL {
+
+
+//uninitialized_copy
+//POD类型直接赋值
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+__uninitialized_copy_aux(InputIterator first, InputIterator last,
+                         ForwardIterator result, __true_type)
+{
+        return SimSTL::copy(first, last, result);
+}
+
+//非POD类型逐个构造，构造失败则析构已构造的元素
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator
+__uninitialized_copy_aux(InputIterator first, InputIterator last,
+                         ForwardIterator result, __false_type)
+{
+        ForwardIterator cur = result;
+        try {
+                for (; first != last; ++first, ++cur)
+                        construct(&*cur, *first);
+                return cur;
+        }
+        catch(...) {
+                SimSTL::destroy(result, cur);
+                throw;
+        }
+}
+
+template <typename InputIterator, typename ForwardIterator, typename T>
+inline ForwardIterator
+__uninitialized_copy(InputIterator first, InputIterator last,
+                     ForwardIterator result, T*)
+{
+        typedef typename __type_traits<T>::is_POD_type is_POD;
+        return __uninitialized_copy_aux(first, last, result, is_POD());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result)
+{
+        return __uninitialized_copy(first, last, result, value_type(result));
+}
+
+
+//uninitialized_fill
+template <typename ForwardIterator, typename T>
+inline void
+__uninitialized_fill_aux(ForwardIterator first, ForwardIterator last,
+                         const T& x, __true_type)
+{
+        SimSTL::fill(first, last, x);
+}
+
+template <typename ForwardIterator, typename T>
+void
+__uninitialized_fill_aux(ForwardIterator first, ForwardIterator last,
+                         const T& x, __false_type)
+{
+        ForwardIterator cur = first;
+        try {
+                for (; cur != last; ++cur)
+                        construct(&*cur, x);
+        }
+        catch(...) {
+                SimSTL::destroy(first, cur);
+                throw;
+        }
+}
+
+template <typename ForwardIterator, typename T, typename T1>
+inline void
+__uninitialized_fill(ForwardIterator first, ForwardIterator last,
+                     const T& x, T1*)
+{
+        typedef typename __type_traits<T1>::is_POD_type is_POD;
+        __uninitialized_fill_aux(first, last, x, is_POD());
+}
+
+template <typename ForwardIterator, typename T>
+inline void
+uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x)
+{
+        __uninitialized_fill(first, last, x, value_type(first));
+}
+
+
+//uninitialized_fill_n
+template <typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator
+__uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __true_type)
+{
+        return SimSTL::fill_n(first, n, x);
+}
+
+template <typename ForwardIterator, typename Size, typename T>
+ForwardIterator
+__uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __false_type)
+{
+        ForwardIterator cur = first;
+        try {
+                for (; n > 0; --n, ++cur)
+                        construct(&*cur, x);
+                return cur;
+        }
+        catch(...) {
+                SimSTL::destroy(first, cur);
+                throw;
+        }
+}
+
+template <typename ForwardIterator, typename Size, typename T, typename T1>
+inline ForwardIterator
+__uninitialized_fill_n(ForwardIterator first, Size n, const T& x, T1*)
+{
+        typedef typename __type_traits<T1>::is_POD_type is_POD;
+        return __uninitialized_fill_n_aux(first, n, x, is_POD());
+}
+
+template <typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator
+uninitialized_fill_n(ForwardIterator first, Size n, const T& x)
+{
+        return __uninitialized_fill_n(first, n, x, value_type(first));
+}
+
+
+//uninitialized_default_n
+//trivial默认构造函数什么也不做，直接跳过
+template <typename ForwardIterator, typename Size>
+inline ForwardIterator
+__uninitialized_default_n_aux(ForwardIterator first, Size n, __true_type)
+{
+        SimSTL::advance(first, n);
+        return first;
+}
+
+template <typename ForwardIterator, typename Size>
+ForwardIterator
+__uninitialized_default_n_aux(ForwardIterator first, Size n, __false_type)
+{
+        ForwardIterator cur = first;
+        try {
+                for (; n > 0; --n, ++cur)
+                        construct_default(&*cur);
+                return cur;
+        }
+        catch(...) {
+                SimSTL::destroy(first, cur);
+                throw;
+        }
+}
+
+template <typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator
+__uninitialized_default_n(ForwardIterator first, Size n, T*)
+{
+        typedef typename __type_traits<T>::has_trivial_default_constructor trivial;
+        return __uninitialized_default_n_aux(first, n, trivial());
+}
+
+//对[first, first + n)默认初始化
+template <typename ForwardIterator, typename Size>
+inline ForwardIterator
+uninitialized_default_n(ForwardIterator first, Size n)
+{
+        return __uninitialized_default_n(first, n, value_type(first));
+}
+
+
+//uninitialized_move
+//与uninitialized_copy相同，但以移动构造代替复制构造
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+__uninitialized_move_aux(InputIterator first, InputIterator last,
+                         ForwardIterator result, __true_type)
+{
+        return SimSTL::copy(first, last, result);
+}
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator
+__uninitialized_move_aux(InputIterator first, InputIterator last,
+                         ForwardIterator result, __false_type)
+{
+        ForwardIterator cur = result;
+        try {
+                for (; first != last; ++first, ++cur)
+                        construct(&*cur, std::move(*first));
+                return cur;
+        }
+        catch(...) {
+                SimSTL::destroy(result, cur);
+                throw;
+        }
+}
+
+template <typename InputIterator, typename ForwardIterator, typename T>
+inline ForwardIterator
+__uninitialized_move(InputIterator first, InputIterator last,
+                     ForwardIterator result, T*)
+{
+        typedef typename __type_traits<T>::is_POD_type is_POD;
+        return __uninitialized_move_aux(first, last, result, is_POD());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+uninitialized_move(InputIterator first, InputIterator last, ForwardIterator result)
+{
+        return __uninitialized_move(first, last, result, value_type(result));
+}
+
+
+//uninitialized_move_if_noexcept
+//移动构造不抛异常时移动，否则复制，构造失败时源区间保持不变
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+__uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last,
+                                     ForwardIterator result, __true_type)
+{
+        return SimSTL::copy(first, last, result);
+}
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator
+__uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last,
+                                     ForwardIterator result, __false_type)
+{
+        ForwardIterator cur = result;
+        try {
+                for (; first != last; ++first, ++cur)
+                        construct(&*cur, std::move_if_noexcept(*first));
+                return cur;
+        }
+        catch(...) {
+                SimSTL::destroy(result, cur);
+                throw;
+        }
+}
+
+template <typename InputIterator, typename ForwardIterator, typename T>
+inline ForwardIterator
+__uninitialized_move_if_noexcept(InputIterator first, InputIterator last,
+                                 ForwardIterator result, T*)
+{
+        typedef typename __type_traits<T>::is_POD_type is_POD;
+        return __uninitialized_move_if_noexcept_aux(first, last, result, is_POD());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+uninitialized_move_if_noexcept(InputIterator first, InputIterator last,
+                               ForwardIterator result)
+{
+        return __uninitialized_move_if_noexcept(first, last, result, value_type(result));
+}
+
+
+}
+
+#endif
@@ -0,0 +1,569 @@
+#ifndef _MINISTL_UNROLLED_LIST_H_
+#define _MINISTL_UNROLLED_LIST_H_
+
+#include "simiterator.h"
+#include "simalloc.h"
+#include "simalgobase.h"
+#include "simconstruct.h"
+#include "simuninitialized.h"
+#include <cstddef>
+#include <utility> //for std::move, std::forward
+
+namespace SimSTL {
+
+
+// unrolled_list节点的链接部分，空白节点只有这一部分，count为0
+struct __unrolled_node_base
+{
+        __unrolled_node_base *prev;
+        __unrolled_node_base *next;
+        size_t count;  //节点中的元素个数
+};
+
+// unrolled_list节点，一个节点存放至多N个元素，元素在elems()[0, count)中连续存放
+template <typename T, size_t N>
+struct __unrolled_node : public __unrolled_node_base
+{
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+
+        T *elems() { return (T *)buffer; }
+};
+
+//每个节点容纳的元素个数：节点约为两条cache line（128字节），至少4个
+template <typename T>
+struct __unrolled_capacity
+{
+        enum { bytes = 128 - sizeof(__unrolled_node_base) };
+        enum { value = sizeof(T) * 4 > bytes ? 4 : bytes / sizeof(T) };
+};
+
+// unrolled_list迭代器，由节点和节点内的下标组成
+template <typename T, typename Ref, typename Ptr, size_t N>
+struct __unrolled_iterator
+{
+        typedef __unrolled_iterator<T, T&, T*, N>               iterator;
+        typedef __unrolled_iterator<T, const T&, const T*, N>   const_iterator;
+        typedef __unrolled_iterator<T, Ref, Ptr, N>             self;
+
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef T               value_type;
+        typedef ptrdiff_t       difference_type;
+        typedef Ptr             pointer;
+        typedef Ref             reference;
+        typedef size_t          size_type;
+        typedef __unrolled_node<T, N>*  link_type;
+        typedef __unrolled_node_base*   base_ptr;
+
+        base_ptr node;
+        size_type index;
+
+        // constructor
+        __unrolled_iterator(base_ptr x, size_type i) : node(x), index(i) {}
+        __unrolled_iterator() : node(0), index(0) {}
+        __unrolled_iterator(const __unrolled_iterator&) = default;
+        __unrolled_iterator& operator=(const __unrolled_iterator&) = default;
+        //iterator转换为const_iterator，只接受元素指针为T*的迭代器
+        template <typename R>
+        __unrolled_iterator(const __unrolled_iterator<T, R, T*, N>& x) : node(x.node), index(x.index) {}
+
+        bool operator==(const self& x) const { return node == x.node && index == x.index; }
+        bool operator!=(const self& x) const { return !(*this == x); }
+        reference operator*() const { return ((link_type)node)->elems()[index]; }
+        pointer operator->() const { return &(operator*()); }
+        self& operator++()
+        {
+                if (++index == node->count)  //空白节点的count为0，end()的index为0
+                {
+                        node = node->next;
+                        index = 0;
+                }
+                return *this;
+        }
+        self operator++(int)
+        {
+                self tmp = *this;
+                ++*this;
+                return tmp;
+        }
+        self& operator--()
+        {
+                if (index == 0)
+                {
+                        node = node->prev;
+                        index = node->count;
+                }
+                --index;
+                return *this;
+        }
+        self operator--(int)
+        {
+                self tmp = *this;
+                --*this;
+                return tmp;
+        }
+};
+
+// unrolled_list
+//每个节点存放一小段连续的元素，遍历时每条cache line读到多个元素。
+//插入时节点已满则分裂为两个半满的节点，删除后节点过空则与后一个节点合并。
+//插入和删除会搬移同一节点（分裂、合并时还有相邻节点）中的元素，
+//指向这些元素的迭代器随之失效，其余节点中的迭代器仍然有效
+template <typename T, typename Alloc = alloc, size_t N = __unrolled_capacity<T>::value>
+class unrolled_list : private __alloc_holder<Alloc>
+{
+        static_assert(N >= 2, "unrolled_list nodes need room for at least two elements");
+
+public:
+        // 基础类型
+        typedef T                       value_type;
+        typedef ptrdiff_t               difference_type;
+        typedef value_type*             pointer;
+        typedef const value_type*       const_pointer;
+        typedef value_type&             reference;
+        typedef const value_type&       const_reference;
+        typedef size_t                  size_type;
+
+        typedef __unrolled_node<T, N>   list_node;
+        typedef list_node*              link_type;
+        typedef __unrolled_node_base*   base_ptr;
+
+        // 空间配置器
+        typedef simple_alloc<list_node, Alloc> list_node_allocator;
+        typedef Alloc allocator_type;
+
+        allocator_type get_allocator() const { return this->get_alloc(); }
+
+        // 迭代器
+        typedef __unrolled_iterator<T, T&, T*, N>               iterator;
+        typedef __unrolled_iterator<T, const T&, const T*, N>   const_iterator;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+
+
+private:
+        typedef __alloc_holder<Alloc> alloc_holder;
+
+        //空白节点直接放在对象中，count恒为0
+        __unrolled_node_base    node;
+        size_type               length;
+
+        base_ptr head() const { return const_cast<base_ptr>(&node); }
+
+private:
+        // 内部操作
+        link_type get_node()
+        {
+                link_type p = list_node_allocator::allocate(this->get_alloc(), 1);
+                p->count = 0;
+                return p;
+        }
+        void put_node(link_type p) { list_node_allocator::deallocate(this->get_alloc(), p, 1); }
+
+        //将节点p链入position之前
+        static void link_node(base_ptr position, base_ptr p)
+        {
+                p->next = position;
+                p->prev = position->prev;
+                position->prev->next = p;
+                position->prev = p;
+        }
+
+        static void unlink_node(base_ptr p)
+        {
+                p->prev->next = p->next;
+                p->next->prev = p->prev;
+        }
+
+        void empty_initialize()
+        {
+                node.next = &node;
+                node.prev = &node;
+                node.count = 0;
+                length = 0;
+        }
+
+        //把p的后一半元素搬到新节点，新节点链在p之后
+        void split_node(link_type p);
+
+        //p中元素不足一半且与下一个节点合起来放得下时，把下一个节点的元素并入p
+        void merge_next(link_type p);
+
+        //在未满的节点p中下标i处放入x，其后的元素后移一位
+        static void insert_in_node(link_type p, size_type i, T& x);
+
+        //交换两个对象的节点，空白节点留在原处
+        void swap_nodes(unrolled_list& x);
+
+        template <typename Integer>
+        void initialize_dispatch(Integer n, Integer value, __true_type)
+        {
+                for (; n > 0; --n)
+                        push_back(value);
+        }
+
+        template <typename InputIterator>
+        void initialize_dispatch(InputIterator first, InputIterator last, __false_type)
+        {
+                for (; first != last; ++first)
+                        emplace_back(*first);
+        }
+
+public:
+        unrolled_list() { empty_initialize(); }
+
+        explicit unrolled_list(const allocator_type& a) : alloc_holder(a) { empty_initialize(); }
+
+        //n个值初始化的元素
+        explicit unrolled_list(size_type n, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                empty_initialize();
+                try {
+                        for (; n > 0; --n)
+                                emplace_back();
+                }
+                catch(...) {
+                        clear();
+                        throw;
+                }
+        }
+
+        unrolled_list(size_type n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                empty_initialize();
+                try {
+                        for (; n > 0; --n)
+                                push_back(value);
+                }
+                catch(...) {
+                        clear();
+                        throw;
+                }
+        }
+
+        template <typename InputIterator>
+        unrolled_list(InputIterator first, InputIterator last, const allocator_type& a = allocator_type())
+            : alloc_holder(a)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                empty_initialize();
+                try {
+                        initialize_dispatch(first, last, integral());
+                }
+                catch(...) {
+                        clear();
+                        throw;
+                }
+        }
+
+        unrolled_list(const unrolled_list& x) : alloc_holder(x.get_alloc())
+        {
+                empty_initialize();
+                try {
+                        initialize_dispatch(x.begin(), x.end(), __false_type());
+                }
+                catch(...) {
+                        clear();
+                        throw;
+                }
+        }
+
+        //接管x的节点和配置器，x变为空
+        unrolled_list(unrolled_list&& x) : alloc_holder(x.get_alloc())
+        {
+                empty_initialize();
+                swap_nodes(x);
+        }
+
+        ~unrolled_list() { clear(); }
+
+        unrolled_list& operator=(const unrolled_list& x)
+        {
+                if (this != &x)
+                {
+                        unrolled_list tmp(x);
+                        swap(tmp);
+                }
+                return *this;
+        }
+
+        unrolled_list& operator=(unrolled_list&& x)
+        {
+                if (this != &x)
+                {
+                        clear();
+                        SimSTL::swap(this->get_alloc(), x.get_alloc());
+                        swap_nodes(x);
+                }
+                return *this;
+        }
+
+        void swap(unrolled_list& x)
+        {
+                SimSTL::swap(this->get_alloc(), x.get_alloc());
+                swap_nodes(x);
+        }
+
+public:
+        iterator begin() { return iterator(node.next, 0); }
+        iterator end() { return iterator(head(), 0); }
+        const_iterator begin() const { return const_iterator(node.next, 0); }
+        const_iterator end() const { return const_iterator(head(), 0); }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        bool empty() const { return length == 0; }
+        size_type size() const { return length; }
+        //每个节点最多容纳的元素个数
+        static size_type node_capacity() { return N; }
+
+        reference front() { return *begin(); }
+        const_reference front() const { return *begin(); }
+        reference back() { return *(--end()); }
+        const_reference back() const { return *(--end()); }
+
+public:
+        //在position之前以args构造元素。插入点在节点末尾且有空位时直接构造，
+        //节点已满时先分裂
+        template <typename... Args>
+        iterator emplace(iterator position, Args&&... args);
+
+        iterator insert(iterator position, const T& x) { return emplace(position, x); }
+        iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args) { emplace(end(), std::forward<Args>(args)...); }
+        template <typename... Args>
+        void emplace_front(Args&&... args) { emplace(begin(), std::forward<Args>(args)...); }
+
+        void push_back(const T& x) { emplace(end(), x); }
+        void push_back(T&& x) { emplace(end(), std::move(x)); }
+        void push_front(const T& x) { emplace(begin(), x); }
+        void push_front(T&& x) { emplace(begin(), std::move(x)); }
+
+        iterator erase(iterator position);
+        iterator erase(iterator first, iterator last);
+
+        void pop_front() { erase(begin()); }
+        void pop_back() { erase(--end()); }
+
+        void clear();
+};
+
+template <typename T, typename Alloc, size_t N>
+void
+unrolled_list<T, Alloc, N>::split_node(link_type p)
+{
+        link_type q = get_node();
+        const size_type keep = p->count - p->count / 2;
+        T *from = p->elems() + keep;
+        try {
+                uninitialized_move_if_noexcept(from, p->elems() + p->count, q->elems());
+        }
+        catch(...) {
+                put_node(q);
+                throw;
+        }
+        SimSTL::destroy(from, p->elems() + p->count);
+        q->count = p->count - keep;
+        p->count = keep;
+        link_node(p->next, q);
+}
+
+template <typename T, typename Alloc, size_t N>
+void
+unrolled_list<T, Alloc, N>::merge_next(link_type p)
+{
+        base_ptr next = p->next;
+        if (next == &node || p->count >= N / 2 || p->count + next->count > N)
+                return ;
+        link_type q = (link_type)next;
+        uninitialized_move_if_noexcept(q->elems(), q->elems() + q->count, p->elems() + p->count);
+        SimSTL::destroy(q->elems(), q->elems() + q->count);
+        p->count += q->count;
+        unlink_node(q);
+        put_node(q);
+}
+
+template <typename T, typename Alloc, size_t N>
+void
+unrolled_list<T, Alloc, N>::insert_in_node(link_type p, size_type i, T& x)
+{
+        T *e = p->elems();
+        if (i == p->count)
+                construct(e + i, std::move(x));
+        else
+        {
+                construct(e + p->count, std::move(e[p->count - 1]));
+                SimSTL::move_backward(e + i, e + p->count - 1, e + p->count);
+                e[i] = std::move(x);
+        }
+        ++p->count;
+}
+
+template <typename T, typename Alloc, size_t N>
+template <typename... Args>
+typename unrolled_list<T, Alloc, N>::iterator
+unrolled_list<T, Alloc, N>::emplace(iterator position, Args&&... args)
+{
+        base_ptr p = position.node;
+        size_type i = position.index;
+        //在节点开头插入时改为放到前一个节点末尾，end()即最后一个节点末尾
+        if (i == 0 && p->prev != &node && p->prev->count < N)
+        {
+                p = p->prev;
+                i = p->count;
+        }
+        else if (p == &node)
+        {
+                p = node.prev;
+                i = p->count;
+        }
+
+        if (p != &node && i == p->count && p->count < N)  //直接在末尾空位构造
+        {
+                construct(((link_type)p)->elems() + i, std::forward<Args>(args)...);
+                ++p->count;
+                ++length;
+                return iterator(p, i);
+        }
+
+        if (p == &node || (i == p->count && p->next == &node))  //在最后配置一个新节点
+        {
+                link_type q = get_node();
+                try {
+                        construct(q->elems(), std::forward<Args>(args)...);
+                }
+                catch(...) {
+                        put_node(q);
+                        throw;
+                }
+                q->count = 1;
+                link_node(&node, q);
+                ++length;
+                return iterator(q, 0);
+        }
+
+        T x_copy(std::forward<Args>(args)...);  //args可能引用将被搬移的元素
+        link_type cur = (link_type)p;
+        if (cur->count == N)
+        {
+                split_node(cur);
+                if (i > cur->count)
+                {
+                        i -= cur->count;
+                        cur = (link_type)cur->next;
+                }
+        }
+        insert_in_node(cur, i, x_copy);
+        ++length;
+        return iterator(cur, i);
+}
+
+template <typename T, typename Alloc, size_t N>
+typename unrolled_list<T, Alloc, N>::iterator
+unrolled_list<T, Alloc, N>::erase(iterator position)
+{
+        link_type p = (link_type)position.node;
+        const size_type i = position.index;
+        T *e = p->elems();
+        SimSTL::move(e + i + 1, e + p->count, e + i);
+        --p->count;
+        SimSTL::destroy(e + p->count);
+        --length;
+
+        if (p->count == 0)
+        {
+                base_ptr next = p->next;
+                unlink_node(p);
+                put_node(p);
+                return iterator(next, 0);
+        }
+        merge_next(p);
+        if (i < p->count)
+                return iterator(p, i);
+        return iterator(p->next, 0);
+}
+
+//合并节点会使last失效，按元素个数逐个删除
+template <typename T, typename Alloc, size_t N>
+typename unrolled_list<T, Alloc, N>::iterator
+unrolled_list<T, Alloc, N>::erase(iterator first, iterator last)
+{
+        size_type n = (size_type)SimSTL::distance(first, last);
+        for (; n > 0; --n)
+                first = erase(first);
+        return first;
+}
+
+template <typename T, typename Alloc, size_t N>
+void
+unrolled_list<T, Alloc, N>::clear()
+{
+        base_ptr cur = node.next;
+        while (cur != &node)
+        {
+                link_type p = (link_type)cur;
+                cur = cur->next;
+                SimSTL::destroy(p->elems(), p->elems() + p->count);
+                put_node(p);
+        }
+        empty_initialize();
+}
+
+template <typename T, typename Alloc, size_t N>
+void
+unrolled_list<T, Alloc, N>::swap_nodes(unrolled_list& x)
+{
+        const bool this_empty = node.next == &node;
+        const bool x_empty = x.node.next == &x.node;
+        SimSTL::swap(node.next, x.node.next);
+        SimSTL::swap(node.prev, x.node.prev);
+        SimSTL::swap(length, x.length);
+        if (x_empty)
+                node.next = node.prev = &node;
+        else
+                node.next->prev = node.prev->next = &node;
+        if (this_empty)
+                x.node.next = x.node.prev = &x.node;
+        else
+                x.node.next->prev = x.node.prev->next = &x.node;
+}
+
+template <typename T, typename Alloc, size_t N>
+inline void
+swap(unrolled_list<T, Alloc, N>& x, unrolled_list<T, Alloc, N>& y)
+{
+        x.swap(y);
+}
+
+template <typename T, typename Alloc, size_t N>
+inline bool
+operator==(const unrolled_list<T, Alloc, N>& x, const unrolled_list<T, Alloc, N>& y)
+{
+        typedef typename unrolled_list<T, Alloc, N>::const_iterator const_iterator;
+        if (x.size() != y.size())
+                return false;
+        const_iterator first1 = x.begin();
+        const_iterator first2 = y.begin();
+        for (; first1 != x.end(); ++first1, ++first2)
+        {
+                if (!(*first1 == *first2))
+                        return false;
+        }
+        return true;
+}
+
+template <typename T, typename Alloc, size_t N>
+inline bool
+operator!=(const unrolled_list<T, Alloc, N>& x, const unrolled_list<T, Alloc, N>& y)
+{
+        return !(x == y);
+}
+
+
+}
+
+#endif
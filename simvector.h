@@ -4,13 +4,51 @@
 #include "simconstruct.h"
 #include "simalloc.h"
 #include "simiterator.h"
-#include "uninitialized.h"
+#include "simuninitialized.h"
 #include <cstddef>
+#include <cstring> //for memmove
+#include <utility> //for std::move, std::forward
 
 namespace SimSTL {
 
-template <typename T>  //不同：不允许外部的配置器
-class vector
+//vector的扩容策略：next_capacity返回不小于required的新容量，size为当前元素个数，
+//DataAlloc为vector使用的simple_alloc<T, Alloc>
+
+//2倍增长
+struct vector_growth_2x
+{
+        template <typename DataAlloc>
+        static size_t next_capacity(size_t size, size_t required)
+        {
+                return SimSTL::max(2 * size, required);
+        }
+};
+
+//1.5倍增长，空余空间更少
+struct vector_growth_1_5x
+{
+        template <typename DataAlloc>
+        static size_t next_capacity(size_t size, size_t required)
+        {
+                return SimSTL::max(size + size / 2, required);
+        }
+};
+
+//按Base增长后取整到配置器分级的区块大小，区块中多出的空间计入容量而不是闲置
+template <typename Base = vector_growth_1_5x>
+struct vector_growth_size_class
+{
+        template <typename DataAlloc>
+        static size_t next_capacity(size_t size, size_t required)
+        {
+                return DataAlloc::good_size(Base::template next_capacity<DataAlloc>(size, required));
+        }
+};
+
+//Alloc可以是只有静态函数的配置器，也可以是有状态的配置器对象（如arena_ref_alloc），
+//后者保存在vector中，随vector复制、移动和交换
+template <typename T, typename Alloc = alloc, typename Growth = vector_growth_2x>
+class vector : private __alloc_holder<Alloc>
 {
 public:
         typedef T                       value_type;
@@ -22,28 +60,29 @@ public:
         typedef const value_type&       const_reference;
         typedef size_t                  size_type;
         typedef ptrdiff_t               difference_type;
-        typedef MiniSTL::reverse_iterator<iterator>             reverse_iterator;
-        typedef MiniSTL::reverse_iterator<const_iterator>       const_reverse_iterator;
-        typedef alloc allocator_type;
+        typedef SimSTL::reverse_iterator<iterator>              reverse_iterator;
+        typedef SimSTL::reverse_iterator<const_iterator>        const_reverse_iterator;
+        typedef Alloc allocator_type;
 
-        allocator_type get_allocator() const { return allocator_type(); }
+        allocator_type get_allocator() const { return this->get_alloc(); }
 
 
 private:
         typedef simple_alloc<T, allocator_type> data_allocator;
+        typedef __alloc_holder<allocator_type> alloc_holder;
         iterator        start;
         iterator        finish;
         iterator        end_of_storage;
 
 private:
-        pointer* allocate(size_t n)
+        pointer allocate(size_t n)
         {
-                return data_allocator::allocator(n);
+                return data_allocator::allocate(this->get_alloc(), n);
         }
 
         void deallocate(pointer p, size_t n)
         {
-                return data_allocator::deallocate(p, n);
+                return data_allocator::deallocate(this->get_alloc(), p, n);
         }
 
         void fill_initializer(size_type n, const T& value)
@@ -55,36 +94,212 @@ private:
 
         iterator allocate_and_fill(size_type n, const T& value)
         {
-                iterator result = data_allocator::allocate(n);
-                uninitialized_fill_n(result, n, value);
+                iterator result = allocate(n);
+                SimSTL::uninitialized_fill_n(result, n, value);
                 return result;
         }
 
+        //可平凡搬移的类型扩容时交给配置器的reallocate：同一分级直接复用，
+        //大块由realloc原地扩展或由系统搬移页面，不逐个元素构造和析构
+        void reallocate_storage(size_type len)
+        {
+                const size_type old_size = size();
+                start = data_allocator::reallocate(this->get_alloc(), start, capacity(), len);
+                finish = start + old_size;
+                end_of_storage = start + len;
+        }
+
+        //再放入n个元素时扩容后的容量
+        size_type next_capacity(size_type n) const
+        {
+                return Growth::template next_capacity<data_allocator>(size(), size() + n);
+        }
+
+        //把元素搬到容量为len的新空间，len不小于size()
+        void change_capacity(size_type len, __true_type)
+        {
+                if (len == 0)
+                {
+                        deallocate(start, capacity());
+                        start = finish = end_of_storage = 0;
+                }
+                else
+                        reallocate_storage(len);
+        }
+
+        void change_capacity(size_type len, __false_type);
+
+        //把旧元素搬到new_start开始的新空间，在offset处留出n个位置，返回新的finish。
+        //失败时已搬过去的元素被析构，原vector不变
+        iterator relocate_around(iterator new_start, size_type offset, size_type n, __true_type)
+        {
+                const size_type elems_after = size() - offset;
+                memcpy((void *)new_start, (void *)start, offset * sizeof(T));
+                memcpy((void *)(new_start + offset + n), (void *)(start + offset), elems_after * sizeof(T));
+                return new_start + offset + n + elems_after;
+        }
+
+        iterator relocate_around(iterator new_start, size_type offset, size_type n, __false_type)
+        {
+                iterator prefix_end = SimSTL::uninitialized_move_if_noexcept(start, start + offset, new_start);
+                try {
+                        return SimSTL::uninitialized_move_if_noexcept(start + offset, finish, prefix_end + n);
+                }
+                catch(...) {
+                        SimSTL::destroy(new_start, prefix_end);
+                        throw;
+                }
+        }
+
+        //relocate_around之后处理旧空间中的元素：按字节搬走的直接放弃，否则析构
+        void destroy_relocated(__true_type) {}
+        void destroy_relocated(__false_type) { SimSTL::destroy(start, finish); }
+
+        template <typename... Args>
+        void emplace_aux(iterator position, Args&&... args);
+        template <typename... Args>
+        void grow_emplace_aux(__true_type, iterator position, Args&&... args);
+        template <typename... Args>
+        void grow_emplace_aux(__false_type, iterator position, Args&&... args);
+        void shift_emplace_aux(iterator position, T& x, __true_type);
+        void shift_emplace_aux(iterator position, T& x, __false_type);
+        void shift_insert(iterator position, size_type n, const T& x, __true_type);
+        void shift_insert(iterator position, size_type n, const T& x, __false_type);
+        iterator erase_aux(iterator first, iterator last, __true_type);
+        iterator erase_aux(iterator first, iterator last, __false_type);
+        void grow_insert(iterator position, size_type n, const T& x, __true_type);
+        void grow_insert(iterator position, size_type n, const T& x, __false_type);
+
+        //(n, value)形式的整数参数与迭代器区间分开处理
+        template <typename Integer>
+        void initialize_dispatch(Integer n, Integer value, __true_type)
+        {
+                fill_initializer(n, value);
+        }
+
+        template <typename InputIterator>
+        void initialize_dispatch(InputIterator first, InputIterator last, __false_type)
+        {
+                __range_initialize(first, last, iterator_category(first));
+        }
+
+        template <typename Integer>
+        void insert_dispatch(iterator position, Integer n, Integer value, __true_type)
+        {
+                insert(position, (size_type)n, value);
+        }
+
+        template <typename InputIterator>
+        void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+        {
+                range_insert(position, first, last, iterator_category(first));
+        }
+
+        template <typename Integer>
+        void assign_dispatch(Integer n, Integer value, __true_type)
+        {
+                assign((size_type)n, value);
+        }
+
+        template <typename InputIterator>
+        void assign_dispatch(InputIterator first, InputIterator last, __false_type)
+        {
+                range_assign(first, last, iterator_category(first));
+        }
+
+        template <typename InputIterator>
+        void range_insert(iterator position, InputIterator first, InputIterator last,
+                          input_iterator_tag);
+        template <typename ForwardIterator>
+        void range_insert(iterator position, ForwardIterator first, ForwardIterator last,
+                          forward_iterator_tag);
+        template <typename ForwardIterator>
+        void shift_range_insert(iterator position, ForwardIterator first, ForwardIterator last,
+                                size_type n, __true_type);
+        template <typename ForwardIterator>
+        void shift_range_insert(iterator position, ForwardIterator first, ForwardIterator last,
+                                size_type n, __false_type);
+        template <typename ForwardIterator>
+        void grow_range_insert(iterator position, ForwardIterator first, ForwardIterator last,
+                               size_type n);
+
+        template <typename InputIterator>
+        void range_assign(InputIterator first, InputIterator last, input_iterator_tag);
+        template <typename ForwardIterator>
+        void range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
 public:
         vector() : start(0), finish(0), end_of_storage(0) {}
-        explicit vector(size_type n) { fill_initializer(n, T()); }
-        vector(size_t n, const T& value) { fill_initializer(n, value); }
-        vector(int n, const T& value) { fill_initializer(n, value); }
-        vector(long n, const T& value) { fill_initializer(n, value); }
 
-        vector(const vector<T>& x)
+        explicit vector(const allocator_type& a)
+            : alloc_holder(a), start(0), finish(0), end_of_storage(0) {}
+
+        explicit vector(size_type n, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initializer(n, T()); }
+
+        vector(size_t n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initializer(n, value); }
+
+        vector(int n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initializer(n, value); }
+
+        vector(long n, const T& value, const allocator_type& a = allocator_type())
+            : alloc_holder(a) { fill_initializer(n, value); }
+
+        vector(const vector& x) : alloc_holder(x.get_alloc())
         {
-                start = data_allocator::allocate(x.size());
-                finish = uninitialized_copy(x.begin(), x.end(), start);
+                start = allocate(x.size());
+                finish = SimSTL::uninitialized_copy(x.begin(), x.end(), start);
                 end_of_storage = finish;
         }
 
-        vector(iterator first, iterator last)
+        //接管x的空间和配置器，x变为空
+        vector(vector&& x) noexcept
+            : alloc_holder(x.get_alloc()),
+              start(x.start), finish(x.finish), end_of_storage(x.end_of_storage)
         {
-                __range_initialize(first, last, iterator_category(first));
+                x.start = x.finish = x.end_of_storage = 0;
+        }
+
+        template <typename InputIterator>
+        vector(InputIterator first, InputIterator last, const allocator_type& a = allocator_type())
+            : alloc_holder(a), start(0), finish(0), end_of_storage(0)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                initialize_dispatch(first, last, integral());
         }
 
         ~vector()
         {
-                destroy(start, finish);
+                SimSTL::destroy(start, finish);
                 deallocate(start, end_of_storage - start);
         }
 
+        vector& operator=(const vector& x)
+        {
+                if (this != &x)
+                {
+                        vector tmp(x);
+                        swap(tmp);
+                }
+                return *this;
+        }
+
+        vector& operator=(vector&& x) noexcept
+        {
+                vector tmp(std::move(x));
+                swap(tmp);
+                return *this;
+        }
+
+        void swap(vector& x) noexcept
+        {
+                SimSTL::swap(this->get_alloc(), x.get_alloc());
+                SimSTL::swap(start, x.start);
+                SimSTL::swap(finish, x.finish);
+                SimSTL::swap(end_of_storage, x.end_of_storage);
+        }
+
 
 public:
         iterator begin() { return start; }
@@ -98,47 +313,90 @@ public:
         size_t size() const { return size_type(end() - begin()); }
         bool empty() const { return begin() == end(); }
         size_t capacity() const { return size_type(end_of_storage - begin()); }
+
+        //容量至少为n，不会缩小
+        void reserve(size_type n)
+        {
+                typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+                if (n > capacity())
+                        change_capacity(n, relocatable());
+        }
+
+        //释放多余的容量
+        void shrink_to_fit()
+        {
+                typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+                if (capacity() != size())
+                        change_capacity(size(), relocatable());
+        }
         reference operator[](size_type n) { return *(begin() + n); }
         const_reference operator[](size_type n) const { return *(begin() + n); }
 
 public:
-        reference front() const { return *begin(); }
-        reference back() const { return *(end() - 1);}
-        void insert_aux(iterator position, const T& x);
+        reference front() { return *begin(); }
+        const_reference front() const { return *begin(); }
+        reference back() { return *(end() - 1); }
+        const_reference back() const { return *(end() - 1); }
+        void insert_aux(iterator position, const T& x) { emplace_aux(position, x); }
         void insert(iterator position, size_type n, const T& x);
 
-        void push_back(const T& val)
+        iterator insert(iterator position, const T& x) { return emplace(position, x); }
+        iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+
+        //前向迭代器先求出区间长度，至多配置一次空间；输入迭代器只能逐个读取
+        template <typename InputIterator>
+        void insert(iterator position, InputIterator first, InputIterator last)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                insert_dispatch(position, first, last, integral());
+        }
+
+        void assign(size_type n, const T& val);
+
+        template <typename InputIterator>
+        void assign(InputIterator first, InputIterator last)
+        {
+                typedef typename __is_integer<InputIterator>::integral integral;
+                assign_dispatch(first, last, integral());
+        }
+
+        void push_back(const T& val) { emplace_back(val); }
+        void push_back(T&& val) { emplace_back(std::move(val)); }
+
+        //在尾端以args直接构造元素
+        template <typename... Args>
+        void emplace_back(Args&&... args)
         {
                 if (finish != end_of_storage)
                 {
-                        construct(finish, val);
+                        construct(finish, std::forward<Args>(args)...);
                         ++finish;
                 }
                 else
-                        insert_aux(end(), val);
+                        emplace_aux(end(), std::forward<Args>(args)...);
         }
 
-        void pop_back()
+        //在position之前以args构造元素，返回指向新元素的迭代器
+        template <typename... Args>
+        iterator emplace(iterator position, Args&&... args)
         {
-                --finish;
-                destroy(finish);
+                const size_type offset = position - begin();
+                emplace_aux(position, std::forward<Args>(args)...);
+                return begin() + offset;
         }
 
-        iterator erase(iterator position)
+        void pop_back()
         {
-                if (position + 1 != end())
-                        copy(position + 1, end(), position);
                 --finish;
-                destroy(finish);
-                return position;
+                SimSTL::destroy(finish);
         }
 
+        iterator erase(iterator position) { return erase(position, position + 1); }
+
         iterator erase(iterator first, iterator last)
         {
-                iterator __i = copy(last, finish, first);
-                destroy(__i, finish);
-                finish = finish - (last - first);
-                return first;
+                typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+                return erase_aux(first, last, relocatable());
         }
 
         void resize(size_t new_size, const T& val)
@@ -150,6 +408,26 @@ public:
         }
 
         void resize(size_t new_size) { resize(new_size, T()); }
+
+        //新增的元素默认初始化，char、float等类型的缓冲区不清零
+        void resize(size_t new_size, default_init_t)
+        {
+                if (new_size < size())
+                        erase(begin() + new_size, end());
+                else
+                        append_uninitialized(new_size - size());
+        }
+
+        //在尾端追加n个默认初始化的元素，返回指向第一个新元素的指针，供调用者直接写入
+        pointer append_uninitialized(size_type n)
+        {
+                if (size_type(end_of_storage - finish) < n)
+                        reserve(next_capacity(n));
+                pointer result = finish;
+                finish = uninitialized_default_n(finish, n);
+                return result;
+        }
+
         void clear() { erase(begin(), end()); }
 
 public:
@@ -163,101 +441,460 @@ public:
         template<typename ForwardIterator>
         void __range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
         {
-                size_t n = distance(first, last);
-                start = data_allocator::allocate(n);
+                size_t n = SimSTL::distance(first, last);
+                start = allocate(n);
                 end_of_storage = start + n;
-                finish = uninitialized_copy(first, last, start);
+                finish = SimSTL::uninitialized_copy(first, last, start);
         }
 };
 
-template<typename T>
+template <typename T, typename Alloc, typename Growth>
+template <typename... Args>
 void
-vector<T>::insert_aux(iterator position, const T& x)
+vector<T, Alloc, Growth>::emplace_aux(iterator position, Args&&... args)
 {
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
         if (finish != end_of_storage)  //还有备用空间
         {
-                construct(finish, *(finish - 1));
-                ++finish;
-                T x_copy = x;
-                copy_backward(position, finish - 2, finish - 1);
-                *position = x_copy;
+                if (position == finish)
+                {
+                        construct(finish, std::forward<Args>(args)...);
+                        ++finish;
+                        return ;
+                }
+                T x_copy(std::forward<Args>(args)...);  //args可能引用将被移动的元素
+                shift_emplace_aux(position, x_copy, relocatable());
         }
         else
-        {
-                const size_type old_size = size();
-                const size_type len = old_size != 0 ? 2 * old_size : 1;  //2倍原空间大小
-                iterator new_start = data_allocator::allocate(len);
-                iterator new_finish = new_start;
+                grow_emplace_aux(relocatable(), position, std::forward<Args>(args)...);
+}
 
-                try {
-                        new_finish = uninitialized_copy(start, position, new_start);
-                        construct(new_finish, x);
-                        ++new_finish;
-                        new_finish = uninitialized_copy(position, finish, new_finish);
-                }
-                catch(...) {
-                        destroy(new_start, new_finish);
-                        data_allocator::deallocate(new_start, len);
-                        throw;
-                }
+//可平凡搬移：后面的元素整体memmove后移一位，在空出的位置构造x
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::shift_emplace_aux(iterator position, T& x, __true_type)
+{
+        const size_type elems_after = finish - position;
+        memmove((void *)(position + 1), (void *)position, elems_after * sizeof(T));
+        ++finish;
+        try {
+                construct(position, std::move(x));
+        }
+        catch(...) {
+                --finish;
+                memmove((void *)position, (void *)(position + 1), elems_after * sizeof(T));
+                throw;
+        }
+}
 
-                destroy(begin(), end());
-                deallocate(start, end_of_storage - start);
-                start = new_start;
-                finish = new_finish;
-                end_of_storage = new_start + len;
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::shift_emplace_aux(iterator position, T& x, __false_type)
+{
+        construct(finish, std::move(*(finish - 1)));
+        ++finish;
+        SimSTL::move_backward(position, finish - 2, finish - 1);
+        *position = std::move(x);
+}
+
+template <typename T, typename Alloc, typename Growth>
+template <typename... Args>
+void
+vector<T, Alloc, Growth>::grow_emplace_aux(__true_type, iterator position, Args&&... args)
+{
+        T x_copy(std::forward<Args>(args)...);  //args可能位于旧空间
+        const size_type offset = position - start;
+        reallocate_storage(next_capacity(1));
+        emplace_aux(start + offset, std::move(x_copy));
+}
+
+//先在新空间构造新元素（args可能引用旧空间中的元素），再把旧元素搬过去：
+//移动构造不抛异常时移动，否则复制，失败时原vector不变
+template <typename T, typename Alloc, typename Growth>
+template <typename... Args>
+void
+vector<T, Alloc, Growth>::grow_emplace_aux(__false_type, iterator position, Args&&... args)
+{
+        const size_type len = next_capacity(1);
+        const size_type offset = position - start;
+        iterator new_start = allocate(len);
+        iterator new_finish = new_start;
+
+        try {
+                construct(new_start + offset, std::forward<Args>(args)...);
+        }
+        catch(...) {
+                deallocate(new_start, len);
+                throw;
+        }
+
+        try {
+                new_finish = SimSTL::uninitialized_move_if_noexcept(start, position, new_start);
+                ++new_finish;
+                new_finish = SimSTL::uninitialized_move_if_noexcept(position, finish, new_finish);
+        }
+        catch(...) {
+                if (new_finish == new_start)
+                        SimSTL::destroy(new_start + offset);
+                else
+                        SimSTL::destroy(new_start, new_finish);
+                deallocate(new_start, len);
+                throw;
         }
+
+        SimSTL::destroy(begin(), end());
+        deallocate(start, end_of_storage - start);
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
 }
 
-template <typename T>
+template <typename T, typename Alloc, typename Growth>
 void
-vector<T>::insert(iterator position, size_type n, const T& x)
+vector<T, Alloc, Growth>::insert(iterator position, size_type n, const T& x)
 {
         if (n == 0)
                 return ;
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
         if (size_type(end_of_storage - finish) >= n)  //1.备用空间够用
         {
                 T x_copy = x;
-                const size_type elems_after = finish - position;
-                iterator old_finish = finish;
-                if (elems_after > n)  //1.1插入点之后的现有元素个数大于新增元素个数
-                {
-                        uninitialized_copy(finish - n, finish, finish);
-                        finish += n;
-                        copy_backward(position, old_finish - n, old_finish);
-                        fill(position, position + n, x_copy);
-                }
-                else  //1.2
-                {
-                        uninitialized_fill_n(finish, n - elems_after, x_copy);
-                        finish += n - elems_after;
-                        uninitialized_copy(position, old_finish, finish);
-                        finish += elems_after;
-                        fill(position, old_finish, x_copy);
-                }
+                shift_insert(position, n, x_copy, relocatable());
         }
         else  //2.备用空间个数小于新增元素个数
+                grow_insert(position, n, x, relocatable());
+}
+
+//可平凡搬移：后面的元素整体memmove后移n位，在空出的位置填充x
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::shift_insert(iterator position, size_type n, const T& x, __true_type)
+{
+        const size_type elems_after = finish - position;
+        memmove((void *)(position + n), (void *)position, elems_after * sizeof(T));
+        try {
+                SimSTL::uninitialized_fill_n(position, n, x);
+        }
+        catch(...) {
+                memmove((void *)position, (void *)(position + n), elems_after * sizeof(T));
+                throw;
+        }
+        finish += n;
+}
+
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::shift_insert(iterator position, size_type n, const T& x, __false_type)
+{
+        const size_type elems_after = finish - position;
+        iterator old_finish = finish;
+        if (elems_after > n)  //1.1插入点之后的现有元素个数大于新增元素个数
         {
-                const size_type old_size = size();
-                const size_type len = old_size + max(old_size, n);
-                iterator new_start = data_allocator::allocate(len);
-                iterator new_finish = new_start;
+                SimSTL::uninitialized_move(finish - n, finish, finish);
+                finish += n;
+                SimSTL::move_backward(position, old_finish - n, old_finish);
+                SimSTL::fill(position, position + n, x);
+        }
+        else  //1.2
+        {
+                SimSTL::uninitialized_fill_n(finish, n - elems_after, x);
+                finish += n - elems_after;
+                SimSTL::uninitialized_move(position, old_finish, finish);
+                finish += elems_after;
+                SimSTL::fill(position, old_finish, x);
+        }
+}
+
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::grow_insert(iterator position, size_type n, const T& x, __true_type)
+{
+        T x_copy = x;
+        const size_type offset = position - start;
+        reallocate_storage(next_capacity(n));
+        insert(start + offset, n, x_copy);
+}
+
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::grow_insert(iterator position, size_type n, const T& x, __false_type)
+{
+        const size_type len = next_capacity(n);
+        const size_type offset = position - start;
+        iterator new_start = allocate(len);
+        iterator new_finish = new_start;
+
+        //与grow_emplace_aux相同，先填充新元素，x可能引用旧空间中的元素
+        try {
+                SimSTL::uninitialized_fill_n(new_start + offset, n, x);
+        }
+        catch(...) {
+                deallocate(new_start, len);
+                throw;
+        }
+
+        try {
+                new_finish = SimSTL::uninitialized_move_if_noexcept(start, position, new_start);
+                new_finish += n;
+                new_finish = SimSTL::uninitialized_move_if_noexcept(position, finish, new_finish);
+        }
+        catch(...) {
+                if (new_finish == new_start)
+                        SimSTL::destroy(new_start + offset, new_start + offset + n);
+                else
+                        SimSTL::destroy(new_start, new_finish);
+                deallocate(new_start, len);
+                throw;
+        }
+        SimSTL::destroy(start, finish);
+        deallocate(start, end_of_storage - start);
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+}
+
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::assign(size_type n, const T& val)
+{
+        if (n > capacity())
+        {
+                vector tmp(n, val, this->get_alloc());
+                swap(tmp);
+        }
+        else if (n > size())
+        {
+                SimSTL::fill(begin(), end(), val);
+                finish = SimSTL::uninitialized_fill_n(finish, n - size(), val);
+        }
+        else
+                erase(SimSTL::fill_n(begin(), n, val), end());
+}
+
+template <typename T, typename Alloc, typename Growth>
+template <typename InputIterator>
+void
+vector<T, Alloc, Growth>::range_assign(InputIterator first, InputIterator last,
+                                       input_iterator_tag)
+{
+        iterator cur = begin();
+        for (; first != last && cur != end(); ++first, ++cur)
+                *cur = *first;
+        if (first == last)
+                erase(cur, end());
+        else
+                range_insert(end(), first, last, input_iterator_tag());
+}
+
+//容量不够时配置一次新空间并复制，否则覆盖已有元素后在尾端构造或析构多余的元素
+template <typename T, typename Alloc, typename Growth>
+template <typename ForwardIterator>
+void
+vector<T, Alloc, Growth>::range_assign(ForwardIterator first, ForwardIterator last,
+                                       forward_iterator_tag)
+{
+        const size_type n = SimSTL::distance(first, last);
+        if (n > capacity())
+        {
+                iterator new_start = allocate(n);
                 try {
-                        new_finish = uninitialized_copy(start, position, new_start);
-                        new_finish = uninitialized_fill_n(new_finish, n, x);
-                        new_finish = uninitialized_copy(position, finish, new_finish);
+                        SimSTL::uninitialized_copy(first, last, new_start);
                 }
                 catch(...) {
-                        destroy(new_start, new_finish);
-                        data_allocator::deallocate(new_start, len);
+                        deallocate(new_start, n);
                         throw;
                 }
-                destroy(start, finish);
+                SimSTL::destroy(start, finish);
                 deallocate(start, end_of_storage - start);
                 start = new_start;
-                finish = new_finish;
-                end_of_storage = new_start + len;
+                finish = end_of_storage = new_start + n;
         }
+        else if (n > size())
+        {
+                ForwardIterator mid = first;
+                SimSTL::advance(mid, size());
+                SimSTL::copy(first, mid, start);
+                finish = SimSTL::uninitialized_copy(mid, last, finish);
+        }
+        else
+                erase(SimSTL::copy(first, last, start), end());
+}
+
+//输入迭代器：尾端直接追加；其他位置先读入临时vector，再按前向迭代器一次插入
+template <typename T, typename Alloc, typename Growth>
+template <typename InputIterator>
+void
+vector<T, Alloc, Growth>::range_insert(iterator position, InputIterator first,
+                                       InputIterator last, input_iterator_tag)
+{
+        if (position == finish)
+        {
+                for (; first != last; ++first)
+                        emplace_back(*first);
+                return ;
+        }
+        vector tmp(first, last, this->get_alloc());
+        range_insert(position, tmp.begin(), tmp.end(), forward_iterator_tag());
+}
+
+template <typename T, typename Alloc, typename Growth>
+template <typename ForwardIterator>
+void
+vector<T, Alloc, Growth>::range_insert(iterator position, ForwardIterator first,
+                                       ForwardIterator last, forward_iterator_tag)
+{
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+        const size_type n = SimSTL::distance(first, last);
+        if (n == 0)
+                return ;
+        if (size_type(end_of_storage - finish) >= n)
+                shift_range_insert(position, first, last, n, relocatable());
+        else
+                grow_range_insert(position, first, last, n);
+}
+
+//可平凡搬移：后面的元素整体memmove后移n位，再把区间复制到空出的位置
+template <typename T, typename Alloc, typename Growth>
+template <typename ForwardIterator>
+void
+vector<T, Alloc, Growth>::shift_range_insert(iterator position, ForwardIterator first,
+                                             ForwardIterator last, size_type n, __true_type)
+{
+        const size_type elems_after = finish - position;
+        memmove((void *)(position + n), (void *)position, elems_after * sizeof(T));
+        try {
+                SimSTL::uninitialized_copy(first, last, position);
+        }
+        catch(...) {
+                memmove((void *)position, (void *)(position + n), elems_after * sizeof(T));
+                throw;
+        }
+        finish += n;
+}
+
+template <typename T, typename Alloc, typename Growth>
+template <typename ForwardIterator>
+void
+vector<T, Alloc, Growth>::shift_range_insert(iterator position, ForwardIterator first,
+                                             ForwardIterator last, size_type n, __false_type)
+{
+        const size_type elems_after = finish - position;
+        iterator old_finish = finish;
+        if (elems_after > n)
+        {
+                SimSTL::uninitialized_move(finish - n, finish, finish);
+                finish += n;
+                SimSTL::move_backward(position, old_finish - n, old_finish);
+                SimSTL::copy(first, last, position);
+        }
+        else
+        {
+                ForwardIterator mid = first;
+                SimSTL::advance(mid, elems_after);
+                SimSTL::uninitialized_copy(mid, last, finish);
+                finish += n - elems_after;
+                SimSTL::uninitialized_move(position, old_finish, finish);
+                finish += elems_after;
+                SimSTL::copy(first, mid, position);
+        }
+}
+
+//先把区间复制到新空间（区间可能来自本vector），再搬移旧元素，只配置一次
+template <typename T, typename Alloc, typename Growth>
+template <typename ForwardIterator>
+void
+vector<T, Alloc, Growth>::grow_range_insert(iterator position, ForwardIterator first,
+                                            ForwardIterator last, size_type n)
+{
+        typedef typename __type_traits<T>::is_trivially_relocatable relocatable;
+        const size_type len = next_capacity(n);
+        const size_type offset = position - start;
+        iterator new_start = allocate(len);
+        iterator new_finish = new_start;
+
+        try {
+                SimSTL::uninitialized_copy(first, last, new_start + offset);
+        }
+        catch(...) {
+                deallocate(new_start, len);
+                throw;
+        }
+
+        try {
+                new_finish = relocate_around(new_start, offset, n, relocatable());
+        }
+        catch(...) {
+                SimSTL::destroy(new_start + offset, new_start + offset + n);
+                deallocate(new_start, len);
+                throw;
+        }
+
+        destroy_relocated(relocatable());
+        deallocate(start, end_of_storage - start);
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+}
+
+//移动构造不抛异常时移动，否则复制，失败时原vector不变
+template <typename T, typename Alloc, typename Growth>
+void
+vector<T, Alloc, Growth>::change_capacity(size_type len, __false_type)
+{
+        iterator new_start = allocate(len);
+        iterator new_finish;
+        try {
+                new_finish = SimSTL::uninitialized_move_if_noexcept(start, finish, new_start);
+        }
+        catch(...) {
+                deallocate(new_start, len);
+                throw;
+        }
+        SimSTL::destroy(start, finish);
+        deallocate(start, end_of_storage - start);
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+}
+
+//可平凡搬移：析构被删除的元素后把后面的元素整体memmove前移
+template <typename T, typename Alloc, typename Growth>
+typename vector<T, Alloc, Growth>::iterator
+vector<T, Alloc, Growth>::erase_aux(iterator first, iterator last, __true_type)
+{
+        SimSTL::destroy(first, last);
+        memmove((void *)first, (void *)last, (finish - last) * sizeof(T));
+        finish -= last - first;
+        return first;
+}
+
+template <typename T, typename Alloc, typename Growth>
+typename vector<T, Alloc, Growth>::iterator
+vector<T, Alloc, Growth>::erase_aux(iterator first, iterator last, __false_type)
+{
+        iterator i = SimSTL::move(last, finish, first);
+        SimSTL::destroy(i, finish);
+        finish = i;
+        return first;
+}
+
+//vector只持有指向堆内存的指针，可以平凡搬移，vector<vector<T> >扩容时直接memcpy
+template <typename T, typename Alloc, typename Growth>
+struct __type_traits<vector<T, Alloc, Growth> >
+{
+        typedef __false_type has_trivial_default_constructor;
+        typedef __false_type has_trivial_copy_constructor;
+        typedef __false_type has_trivial_assignment_operator;
+        typedef __false_type has_trivial_destructor;
+        typedef __false_type is_POD_type;
+        typedef __true_type is_trivially_relocatable;
+};
+
+template <typename T, typename Alloc, typename Growth>
+inline void
+swap(vector<T, Alloc, Growth>& x, vector<T, Alloc, Growth>& y)
+{
+        x.swap(y);
 }
 
 }